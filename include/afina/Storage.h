@@ -1,7 +1,10 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
@@ -10,6 +13,12 @@ namespace Afina {
  */
 class Storage {
 public:
+    /**
+     * Immutable value shared by storage with its readers. Bytes stay valid while handle is alive, even
+     * if the key was updated or evicted in the meantime
+     */
+    using Value = std::shared_ptr<const std::string>;
+
     Storage() {}
     virtual ~Storage() {}
 
@@ -84,6 +93,33 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Retrive value for the given key without copying it, if storage is able to share it. Storage locks
+     * are held only to find the value, so readers of large values don't block writers
+     *
+     * Default implementation wraps copy made by the method above
+     *
+     * @param key to retrive value for
+     * @param value output parameter to place handle to
+     */
+    virtual bool Get(const std::string &key, Value &value) {
+        std::string copy;
+        if (!Get(key, copy)) {
+            return false;
+        }
+        value = std::make_shared<const std::string>(std::move(copy));
+        return true;
+    }
+
+    /**
+     * Appends storage statistics to the given list as name/value pairs, in the same
+     * form memcached reports them on "stats" command. Storage that has nothing to report
+     * leaves list untouched
+     *
+     * @param stats output parameter to append statistics to
+     */
+    virtual void GetStats(std::vector<std::pair<std::string, std::string>> &stats) {}
 };
 
 } // namespace Afina
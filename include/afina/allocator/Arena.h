@@ -0,0 +1,68 @@
+#ifndef AFINA_ALLOCATOR_ARENA_H
+#define AFINA_ALLOCATOR_ARENA_H
+
+#include <cstddef>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Anonymous memory region mapped with mmap
+ * Provides memory to be wrapped by allocators. Region is mapped once and pre-faulted, so that
+ * the cache doesn't hit page faults on the hot path.
+ *
+ * If huge pages are requested region is mapped with MAP_HUGETLB first, that requires pages to be
+ * reserved in /proc/sys/vm/nr_hugepages. Otherwise region is aligned on the huge page boundary
+ * and marked for transparent huge pages with madvise. If that is not supported as well regular
+ * pages are used. Actual mode is reported by mode().
+ */
+class Arena {
+public:
+    enum class PageMode {
+        // Explicit huge pages, MAP_HUGETLB
+        HugeTLB,
+
+        // Transparent huge pages, MADV_HUGEPAGE
+        Transparent,
+
+        // Regular pages of the system page size
+        Regular,
+    };
+
+    /**
+     * Maps region, throws std::runtime_error if even regular pages couldn't be mapped
+     *
+     * @param size minimum size of the region, it is rounded up to the page size
+     * @param huge_pages try to use huge pages
+     */
+    Arena(size_t size, bool huge_pages = true);
+    ~Arena();
+
+    inline void *base() const { return _base; }
+    inline size_t size() const { return _size; }
+    inline PageMode mode() const { return _mode; }
+
+    /**
+     * Name of the page mode: "hugetlb", "thp" or "4k"
+     */
+    const char *mode_name() const;
+
+private:
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Start and length of region to be used
+    void *_base;
+    size_t _size;
+
+    // What has been mapped actually, could be larger than used region because of alignment
+    void *_mapped;
+    size_t _mapped_size;
+
+    PageMode _mode;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_ARENA_H
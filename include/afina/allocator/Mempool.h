@@ -0,0 +1,128 @@
+#ifndef AFINA_ALLOCATOR_MEMPOOL_H
+#define AFINA_ALLOCATOR_MEMPOOL_H
+
+#include <atomic>
+#include <cstddef>
+
+#include <afina/allocator/SlabCache.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Thread safe pool of equally sized objects
+ * Objects are carved from slabs of the SlabCache. Free objects are grouped into magazines, i.e
+ * singly linked lists of up to magazine_size objects, and every thread works with its own
+ * ThreadCache holding two magazines. Allocation and release touch only thread own magazines,
+ * shared state is involved once per magazine_size operations: full magazines are exchanged
+ * through the lock-free depot, and fresh slab is requested from the SlabCache only if depot is
+ * empty.
+ *
+ * Slabs are not returned to the SlabCache until the pool is destroyed. All ThreadCache instances
+ * must be destroyed before the pool.
+ */
+class Mempool {
+public:
+    /**
+     * Front end of the pool owned by a single thread, it is not thread safe by itself
+     */
+    class ThreadCache {
+    public:
+        ThreadCache(Mempool &pool);
+
+        /**
+         * Returns all cached objects back to the pool depot
+         */
+        ~ThreadCache();
+
+        /**
+         * Returns new object or nullptr if slab cache is exhausted and there are no free
+         * objects in the depot
+         */
+        void *alloc();
+
+        /**
+         * Returns object back, it could be allocated by any ThreadCache of the same pool
+         */
+        void free(void *obj);
+
+    private:
+        ThreadCache(const ThreadCache &) = delete;
+        ThreadCache &operator=(const ThreadCache &) = delete;
+
+        // Replaces loaded magazine with a full one: from depot or from fresh slab
+        bool _refill();
+
+        Mempool &_pool;
+
+        // Magazine objects are taken from and released to
+        void *_loaded;
+        size_t _loaded_count;
+
+        // Previously loaded magazine, swapped with loaded one to absorb alloc/free ping-pong
+        // without touching depot
+        void *_previous;
+        size_t _previous_count;
+    };
+
+    /**
+     * @param object_size size of objects, rounded up to 8 bytes and at least 3 pointers
+     * @param magazine_size number of objects in the full magazine
+     */
+    Mempool(SlabCache &cache, size_t object_size, size_t magazine_size = 32);
+
+    /**
+     * Returns all slabs back to the cache
+     */
+    ~Mempool();
+
+    inline size_t object_size() const { return _object_size; }
+
+    /**
+     * Number of objects fitting into one slab
+     */
+    inline size_t objects_per_slab() const { return _per_slab; }
+
+    /**
+     * True if object was allocated by the pool or by another one over the same cache, i.e. it
+     * wasn't taken from elsewhere when the pool got exhausted
+     */
+    inline bool owns(const void *obj) const { return _cache.contains(obj); }
+
+    /**
+     * Number of slabs taken from the cache
+     */
+    inline size_t slabs() const { return _slabs.load(std::memory_order_relaxed); }
+
+private:
+    Mempool(const Mempool &) = delete;
+    Mempool &operator=(const Mempool &) = delete;
+
+    // Puts magazine of count objects headed by the given one into depot
+    void _put_magazine(void *head, size_t count);
+
+    // Takes magazine from depot, returns its head and sets count
+    void *_get_magazine(size_t &count);
+
+    // Takes new slab from the cache and cuts it into magazines, first one is returned
+    void *_carve_slab(size_t &count);
+
+    SlabCache &_cache;
+    size_t _object_size;
+    size_t _magazine_size;
+    size_t _per_slab;
+
+    // Number of slabs taken from the cache
+    std::atomic<size_t> _slabs;
+
+    // Magazines available for any thread
+    TaggedStack _depot;
+
+    // Slabs owned by the pool, first word of slab is reserved for the link
+    TaggedStack _owned;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_MEMPOOL_H
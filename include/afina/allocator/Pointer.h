@@ -7,6 +7,13 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Handle of the memory block allocated by Simple. Block could be moved by allocator during
+ * defragmentation, so handle references an entry in the allocator's indirection table rather
+ * than memory itself. Address returned by get() is valid until next defrag()/realloc() call.
+ *
+ * Default constructed pointer references nothing and get() returns nullptr
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +24,15 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _slot == nullptr ? nullptr : *_slot; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **slot) : _slot(slot) {}
+
+    // Entry of the indirection table that keeps current address of the block
+    void **_slot;
 };
 
 } // namespace Allocator
@@ -0,0 +1,79 @@
+#ifndef AFINA_ALLOCATOR_POOL_SET_H
+#define AFINA_ALLOCATOR_POOL_SET_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/SlabCache.h>
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Size classed object pools
+ * Mempools of power of two object sizes sharing one SlabCache, serves blocks of any size up to the
+ * largest class. Every thread works through its own ThreadCache of each pool, so threads allocate
+ * and free without a shared lock, see Mempool.
+ *
+ * Pools don't grow beyond the area: alloc returns nullptr once it is exhausted or if size is above
+ * the largest class, caller is expected to use heap then and to tell such blocks apart by owns().
+ * Thread caches are dropped when thread exits or the set is destroyed, whatever happens first.
+ */
+class PoolSet {
+public:
+    /**
+     * @param base start of memory area, it isn't owned by the set
+     * @param size size of the area
+     * @param max_object size of the largest class, classes start from 64 bytes
+     * @param slab_size size of slabs area is split into, must fit max_object
+     */
+    PoolSet(void *base, size_t size, size_t max_object = 2048, size_t slab_size = 64 * 1024);
+
+    /**
+     * Returns block of at least given size or nullptr if there is no room for it
+     */
+    void *alloc(size_t size);
+
+    /**
+     * Returns block back, size must be the one it was allocated with. Block could be
+     * allocated by any thread
+     */
+    void free(void *ptr, size_t size);
+
+    /**
+     * True if block was allocated by the set rather than taken elsewhere
+     */
+    inline bool owns(const void *ptr) const { return _slabs.contains(ptr); }
+
+    inline size_t max_object() const { return _max_object; }
+
+private:
+    PoolSet(const PoolSet &) = delete;
+    PoolSet &operator=(const PoolSet &) = delete;
+
+    // Caches of the thread for each class, created on first use
+    struct thread_caches {
+        std::vector<std::unique_ptr<Mempool::ThreadCache>> items;
+    };
+
+    // Cache of the current thread for pool of the given class
+    Mempool::ThreadCache &_cache(size_t cls);
+
+    size_t _max_object;
+
+    SlabCache _slabs;
+
+    // Pool of each class, i-th one has objects of 64 << i bytes
+    std::vector<std::unique_ptr<Mempool>> _pools;
+
+    // Must be destroyed before pools
+    Concurrency::ThreadLocal<thread_caches> _caches;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_POOL_SET_H
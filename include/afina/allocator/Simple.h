@@ -1,8 +1,12 @@
 #ifndef AFINA_ALLOCATOR_SIMPLE_H
 #define AFINA_ALLOCATOR_SIMPLE_H
 
-#include <string>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
 
 namespace Afina {
 namespace Allocator {
@@ -11,6 +15,32 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Pointer;
 
+/**
+ * Usage statistics of the single slab class
+ */
+struct SlabClassStats {
+    // Size of chunks in the class, 0 for the blocks spanning whole slabs
+    size_t chunk_size;
+
+    // Number of slabs currently assigned to the class
+    size_t slabs;
+
+    // Number of chunks in use
+    size_t used_chunks;
+
+    // Number of chunks available in the slabs of the class
+    size_t free_chunks;
+
+    // Number of successful allocations
+    uint64_t allocs;
+
+    // Number of allocations failed due to lack of memory
+    uint64_t failures;
+
+    // Number of blocks released by evict()
+    uint64_t evictions;
+};
+
 /**
  * Wraps given memory area and provides defagmentation allocator interface on
  * the top of it.
@@ -18,44 +48,278 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Memory is split into equal slabs. Each slab is either free or assigned to one size
+ * class and cut into the chunks of that class size, much like memcached does. Class sizes
+ * grow geometrically up to a half of slab, larger requests get a run of contiguous slabs.
+ * Slab that has no chunks in use goes back to the free pool and could be taken by any
+ * other class.
+ *
+ * Blocks are referenced by Pointer handles through the indirection table, which allows defrag()
+ * to move blocks out of sparsely used slabs without invalidating handles.
+ *
+ * Allocator metadata lives outside of the wrapped memory, so the whole area is available
+ * for user data. Instance is NOT thread safe.
  */
-// TODO: Implements interface to allow usage as C++ allocators
+// See StlAdapter.h for the interface to use as C++ allocator
 class Simple {
 public:
+    /**
+     * Called once block gets moved by defragmentation
+     */
+    using relocate_func = std::function<void(void *from, void *to)>;
+
+    /**
+     * Slab size is selected automatically: the area is split into at least 128 slabs,
+     * but no slab is larger than 1Mb
+     */
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * @param slab_size size of each slab, must be power of 2 between 256 bytes and 1Gb
+     */
+    Simple(void *base, const size_t size, const size_t slab_size);
+
+    /**
+     * Allocates block of at least N bytes. Returned block is 8 bytes aligned.
+     * Throws AllocError with NoMemory type if there is no space for the block
+     *
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block referenced by p so that it could hold at least N bytes,
+     * first min(N, old size) bytes of content are preserved. Block stays in place when it is
+     * possible, otherwise it is moved, all copies of p remain valid. Empty p is the same as alloc.
+     * Throws AllocError with NoMemory type if block couldn't be grown, p remains valid in
+     * this case
+     *
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block referenced by p, after call p references nothing and its copies
+     * become dangling. Releasing of empty pointer does nothing, pointer that doesn't
+     * reference a live block allocated by this instance causes AllocError with InvalidFree type
+     *
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Same as free but block is accounted as evicted in the stats of its class. That allows
+     * cache built on the top of allocator to report how much each class suffers from lack
+     * of memory
+     *
+     * @param p Pointer
+     */
+    void evict(Pointer &p);
+
+    /**
+     * Allocates block that is never moved by defrag(), so it could be referenced by raw address
+     * the same way as malloc'ed memory. Slabs holding pinned blocks are skipped by compaction, so
+     * pinned blocks are intended for long living data only, like containers internals.
+     * Throws AllocError with NoMemory type if there is no space for the block
+     *
+     * @param N size_t
+     */
+    void *alloc_pinned(size_t N);
+
+    /**
+     * Releases block allocated by alloc_pinned, nullptr is ignored. Address that isn't a live
+     * pinned block causes AllocError with InvalidFree type
+     *
+     * @param ptr void*
+     */
+    void free_pinned(void *ptr);
+
+    /**
+     * Compacts memory: in each class blocks are moved out of sparsely used slabs into holes of
+     * denser ones, evacuated slabs get back to the free pool and become available for any
+     * size. Content of moved blocks is preserved and all Pointers remain valid, but addresses
+     * obtained by Pointer::get() before the call might be stale
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Performs part of defrag() work moving no more than budget bytes, allows to spread
+     * compaction across short time slices, for example between requests. Returns true if
+     * there is more work to do
+     *
+     * @param budget maximum number of bytes to move
+     */
+    bool defrag_step(size_t budget);
+
+    /**
+     * Registers callback which is called after each block moved by defragmentation. Owner could use
+     * it to fix raw addresses derived from Pointer::get(), for example intrusive links
+     *
+     * @param f callback, empty function to unregister
+     */
+    void on_relocate(relocate_func f) { _on_relocate = f; }
+
+    /**
+     * Returns human readable description of the allocator state
      */
     std::string dump() const;
 
+    /**
+     * Returns stats of each slab class ordered by chunk size, the last element
+     * describes multi slab blocks
+     */
+    std::vector<SlabClassStats> stats() const;
+
+    /**
+     * Index of the class blocks of N bytes are allocated from, classes are numbered the same way
+     * as in stats(), so multi slab blocks belong to the last one
+     *
+     * @param N size_t
+     */
+    size_t class_of(size_t N) const;
+
+    /**
+     * Class of the live block referenced by p, see above. Throws AllocError with InvalidFree
+     * type if p doesn't reference a live block
+     *
+     * @param p Pointer
+     */
+    size_t class_of(const Pointer &p) const;
+
+    /**
+     * Size of the single slab
+     */
+    size_t slab_size() const { return _slab_size; }
+
 private:
-    void *_base;
+    // Slab isn't assigned to any class
+    static const int32_t kFreeSlab = -1;
+
+    // Slab is the first one in multi slab block
+    static const int32_t kLargeSlab = -2;
+
+    // Slab is continuation of multi slab block
+    static const int32_t kLargeTailSlab = -3;
+
+    // Not a slab index, used as list terminator
+    static const int32_t kNoSlab = -1;
+
+    struct slab {
+        // Class slab assigned to or one of special marks above
+        int32_t cls;
+
+        // Number of chunks in use, or number of slabs in the block for kLargeSlab
+        uint32_t used;
+
+        // Number of chunks ever carved out of the slab, chunks past this mark are free but
+        // not in the free list yet
+        uint32_t carved;
+
+        // List of released chunks, each free chunk stores address of the next one
+        char *free_list;
+
+        // Links in list of partially used slabs of the same class
+        int32_t prev;
+        int32_t next;
+
+        // Handle of each chunk by its number in slab, nullptr for free chunks
+        std::vector<void **> owners;
+
+        // Number of pinned blocks, slab is never evacuated by defrag while there are any
+        uint32_t pinned;
+    };
+
+    struct slab_class {
+        size_t chunk_size;
+        uint32_t per_slab;
+
+        // Head of partially used slabs list, i.e slabs that have at least one free chunk
+        int32_t partial;
+
+        SlabClassStats stats;
+    };
+
+    // Class index for the given size or -1 if block of that size spans whole slabs
+    int32_t _class_for(size_t N) const;
+
+    // Slab index for the given address or kNoSlab if address isn't a block start
+    int32_t _slab_of(void *ptr) const;
+
+    // Slab index of the live block referenced by the handle, throws InvalidFree if there is no such
+    int32_t _slab_of(const Pointer &p) const;
+
+    // Owner slot of the block in the given slab
+    void **&_owner(int32_t idx, void *ptr);
+
+    // Usable size of the block starting at ptr which lives in the given slab
+    size_t _block_size(int32_t idx) const;
+
+    // Finds run of n free slabs, returns index of the first one or kNoSlab
+    int32_t _find_free_run(uint32_t n) const;
+
+    // Allocates block without handle, returns nullptr if there is no memory
+    void *_alloc_block(size_t N);
+    void *_alloc_chunk(int32_t cls);
+    void *_alloc_large(size_t N);
+
+    // Takes one free chunk from the given slab of some class
+    void *_take_chunk(int32_t idx);
+
+    // Releases block that lives in the given slab
+    void _release(int32_t idx, void *ptr);
+
+    // Moves block from one place to another one and updates its owner
+    void _move(int32_t from_idx, void *from, int32_t to_idx, void *to);
+
+    // Selects slab of the class to evacuate, or kNoSlab if compaction of the class is pointless
+    int32_t _defrag_source(int32_t cls) const;
+
+    // Allocates handle for the block
+    void **_new_handle(void *ptr);
+
+    // Assign free slab to the given class
+    void _assign_slab(int32_t idx, int32_t cls);
+
+    void _partial_push(int32_t idx);
+    void _partial_remove(int32_t idx);
+
+    inline char *_slab_start(int32_t idx) const { return _base + size_t(idx) * _slab_size; }
+
+    // Start of the wrapped area, aligned on 8 bytes
+    char *_base;
     const size_t _base_len;
+
+    size_t _slab_size;
+
+    std::vector<slab> _slabs;
+    std::vector<slab_class> _classes;
+
+    // Stats of multi slab blocks
+    SlabClassStats _large_stats;
+
+    // Number of slabs in kFreeSlab state
+    size_t _free_slabs;
+
+    // Indirection table, deque never moves existing elements so entries could be referenced
+    // directly by Pointers
+    std::deque<void *> _handles;
+
+    // Released entries of the indirection table
+    std::vector<void **> _free_handles;
+
+    // Class to continue incremental defragmentation from
+    size_t _defrag_cursor;
+
+    // Number of blocks moved by defragmentation
+    uint64_t _moves;
+
+    // Notified about each moved block
+    relocate_func _on_relocate;
+
+    // Pinned blocks use address of this member as owner, it is never dereferenced
+    void *_pinned;
 };
 
 } // namespace Allocator
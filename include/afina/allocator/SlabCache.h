@@ -0,0 +1,119 @@
+#ifndef AFINA_ALLOCATOR_SLAB_CACHE_H
+#define AFINA_ALLOCATOR_SLAB_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * Lock-free LIFO of memory blocks which all live inside of one memory area. Link to the next
+ * block is kept in the first word of the block itself, so the stack needs no memory of its own.
+ *
+ * Head is a single 64 bit word: lower half is the block offset in 8 byte units, upper half is
+ * a tag incremented on every change. Tag protects pop() from ABA when the same block is popped
+ * and pushed back between reading the head and CAS on it. Memory of popped blocks is never
+ * returned to the system while stack is alive, so reading stale link is harmless: CAS fails
+ * and the operation retries.
+ */
+class TaggedStack {
+public:
+    TaggedStack(void *base) : _base(static_cast<char *>(base)), _head(0) {}
+
+    /**
+     * Pushes block, it must be 8 byte aligned and belong to the area
+     */
+    void push(void *block);
+
+    /**
+     * Pops the most recently pushed block, returns nullptr if stack is empty
+     */
+    void *pop();
+
+    bool empty() const { return uint32_t(_head.load(std::memory_order_relaxed)) == 0; }
+
+private:
+    inline uint32_t _encode(void *block) const {
+        return block == nullptr ? 0 : uint32_t((uintptr_t(block) - uintptr_t(_base)) / 8 + 1);
+    }
+    inline void *_decode(uint32_t ref) const { return ref == 0 ? nullptr : _base + size_t(ref - 1) * 8; }
+
+    // Link to the next block, it could be read by pop() of one thread while another one rewrites it
+    static inline std::atomic<void *> &_link(void *block) { return *static_cast<std::atomic<void *> *>(block); }
+
+    char *_base;
+
+    // {tag:32, ref:32}
+    std::atomic<uint64_t> _head;
+};
+
+/**
+ * # Thread safe depot of equally sized slabs
+ * Splits wrapped memory area into slabs and hands them out to the object pools, the way
+ * tarantool slab_cache does. Area is carved lazily, slabs returned by put() are kept in the
+ * lock-free stack and reused first.
+ *
+ * Cache doesn't take ownership of the wrapped memory. Area must not exceed 32Gb
+ */
+class SlabCache {
+public:
+    /**
+     * @param slab_size size of each slab, must be multiple of 8
+     */
+    SlabCache(void *base, size_t size, size_t slab_size = 64 * 1024);
+
+    /**
+     * Returns free slab or nullptr if whole area is in use
+     */
+    void *get();
+
+    /**
+     * Returns slab previously obtained by get() back to the depot
+     */
+    void put(void *slab);
+
+    inline size_t slab_size() const { return _slab_size; }
+
+    inline void *base() const { return _base; }
+
+    /**
+     * True if pointer belongs to the area
+     */
+    inline bool contains(const void *ptr) const {
+        return ptr >= _base && ptr < _base + _total * _slab_size;
+    }
+
+    /**
+     * Number of slabs currently handed out
+     */
+    inline size_t used() const { return _used.load(std::memory_order_relaxed); }
+
+    /**
+     * Total number of slabs in the area
+     */
+    inline size_t total() const { return _total; }
+
+private:
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    char *_base;
+    size_t _slab_size;
+    size_t _total;
+
+    // Number of slabs carved from the area so far, could overshoot _total under contention
+    std::atomic<size_t> _carved;
+
+    // See used()
+    std::atomic<size_t> _used;
+
+    // Slabs returned to the depot
+    TaggedStack _free;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_CACHE_H
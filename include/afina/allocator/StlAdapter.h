@@ -0,0 +1,80 @@
+#ifndef AFINA_ALLOCATOR_STL_ADAPTER_H
+#define AFINA_ALLOCATOR_STL_ADAPTER_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Simple.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Standard library allocator on the top of Simple
+ * Stateful allocator that places elements of containers into pinned blocks of the given Simple
+ * instance, so that std::vector, std::basic_string, node based containers and so on could live
+ * in the same memory area as the rest of data. Default constructed adapter isn't bound to any
+ * area and uses global operator new instead, that allows to choose memory at runtime without
+ * changing container type.
+ *
+ * Adapters are equal if they use the same area. Adapter is propagated together with container
+ * content on copy, move and swap, so memory is always released to the area it came from.
+ */
+template <typename T> class StlAdapter {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    StlAdapter() noexcept : _area(nullptr) {}
+    StlAdapter(Simple &area) noexcept : _area(&area) {}
+    template <typename U> StlAdapter(const StlAdapter<U> &other) noexcept : _area(other.area()) {}
+
+    /**
+     * Allocates memory for n elements, throws std::bad_alloc if there is no space for them
+     */
+    T *allocate(std::size_t n) {
+        if (_area == nullptr) {
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+
+        static_assert(alignof(T) <= 8, "Area provides 8 bytes alignment only");
+        try {
+            return static_cast<T *>(_area->alloc_pinned(n * sizeof(T)));
+        } catch (AllocError &) {
+            throw std::bad_alloc();
+        }
+    }
+
+    void deallocate(T *p, std::size_t) {
+        if (_area == nullptr) {
+            ::operator delete(p);
+        } else {
+            _area->free_pinned(p);
+        }
+    }
+
+    /**
+     * Area memory comes from, nullptr for the heap
+     */
+    Simple *area() const noexcept { return _area; }
+
+private:
+    Simple *_area;
+};
+
+template <typename T, typename U> bool operator==(const StlAdapter<T> &a, const StlAdapter<U> &b) noexcept {
+    return a.area() == b.area();
+}
+
+template <typename T, typename U> bool operator!=(const StlAdapter<T> &a, const StlAdapter<U> &b) noexcept {
+    return a.area() != b.area();
+}
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_STL_ADAPTER_H
@@ -0,0 +1,106 @@
+#ifndef AFINA_CONCURRENCY_BOUNDED_QUEUE_H
+#define AFINA_CONCURRENCY_BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Bounded lock free queue
+ * Fixed size ring of cells, any number of threads could push and pop concurrently. Each cell has a
+ * sequence number telling whether it is free for the producer of the given position or holds value for
+ * the consumer of it, so producers and consumers compete only by CAS on their own position counter.
+ *
+ * Neither operation waits: push fails if queue is full and pop fails if it is empty.
+ *
+ * See "Bounded MPMC queue", D. Vyukov, 1024cores.net
+ */
+template <typename T> class BoundedQueue {
+public:
+    /**
+     * @param capacity maximum number of items, rounded up to power of 2
+     */
+    explicit BoundedQueue(std::size_t capacity = 1024) : _enqueue(0), _dequeue(0) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _mask = size - 1;
+        _cells.reset(new cell[size]);
+        for (std::size_t i = 0; i < size; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Adds item to the tail. Returns false if queue is full
+     */
+    bool push(const T &item) {
+        std::size_t pos = _enqueue.load(std::memory_order_relaxed);
+        for (;;) {
+            cell &c = _cells[pos & _mask];
+            std::size_t seq = c.sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.item = item;
+                    c.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Cell still holds item pushed a full lap ago
+                return false;
+            } else {
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Takes item from the head. Returns false if queue is empty
+     */
+    bool pop(T &item) {
+        std::size_t pos = _dequeue.load(std::memory_order_relaxed);
+        for (;;) {
+            cell &c = _cells[pos & _mask];
+            std::size_t seq = c.sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+            if (diff == 0) {
+                if (_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = c.item;
+                    c.sequence.store(pos + _mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _dequeue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    struct cell {
+        std::atomic<std::size_t> sequence;
+        T item;
+    };
+
+    std::unique_ptr<cell[]> _cells;
+    std::size_t _mask;
+
+    // Producers and consumers positions, on separate cache lines to not disturb each other
+    alignas(64) std::atomic<std::size_t> _enqueue;
+    alignas(64) std::atomic<std::size_t> _dequeue;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_BOUNDED_QUEUE_H
@@ -1,10 +1,100 @@
 #ifndef AFINA_CONCURRENCY_CORE_LOCAL_H
 #define AFINA_CONCURRENCY_CORE_LOCAL_H
 
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <thread>
+
+#include <sched.h>
+#include <unistd.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class CoreLocal {};
+/**
+ * # Per core storage
+ * Keeps one instance of T for each CPU, thread gets instance of the core it is running on. Each
+ * instance is placed on its own cache lines, so threads running on different cores never bounce
+ * lines between each other while updating them. Reading all instances is the slow path: it is
+ * done by iteration over slots and is meant for rare aggregation, for example stats command.
+ *
+ * Thread could be migrated to another core right after it got its slot, so one slot could still
+ * be used by two threads at once. Updates must be atomic, relaxed atomics are enough and cost
+ * close to plain increment as the line is almost always owned by the current core.
+ *
+ * T must be default constructible.
+ */
+template <typename T> class CoreLocal {
+public:
+    /**
+     * @param cores number of slots, 0 means number of CPUs configured in the system
+     */
+    explicit CoreLocal(std::size_t cores = 0) : _size(cores) {
+        if (_size == 0) {
+            long n = sysconf(_SC_NPROCESSORS_CONF);
+            _size = n > 0 ? std::size_t(n) : 1;
+        }
+
+        void *memory = nullptr;
+        if (posix_memalign(&memory, kCacheLine, _size * sizeof(slot)) != 0) {
+            throw std::bad_alloc();
+        }
+        _slots = static_cast<slot *>(memory);
+        for (std::size_t i = 0; i < _size; i++) {
+            new (&_slots[i]) slot();
+        }
+    }
+
+    ~CoreLocal() {
+        for (std::size_t i = 0; i < _size; i++) {
+            _slots[i].~slot();
+        }
+        free(_slots);
+    }
+
+    /**
+     * Instance of the core current thread is running on
+     */
+    T &local() { return _slots[_current() % _size].value; }
+
+    /**
+     * Number of instances
+     */
+    std::size_t size() const { return _size; }
+
+    /**
+     * Access to any instance, used to aggregate them
+     */
+    T &operator[](std::size_t idx) { return _slots[idx].value; }
+    const T &operator[](std::size_t idx) const { return _slots[idx].value; }
+
+private:
+    CoreLocal(const CoreLocal &) = delete;
+    CoreLocal &operator=(const CoreLocal &) = delete;
+
+    static const std::size_t kCacheLine = 64;
+
+    // Instance starting on its own cache line, size is rounded up to whole number of lines
+    struct alignas(kCacheLine) slot {
+        T value;
+    };
+    static_assert(sizeof(slot) % kCacheLine == 0, "Instances must not share cache lines");
+
+    // Index of current CPU. It is served by vDSO without entering the kernel, if it isn't
+    // available falls back to thread id, which still spreads threads across slots
+    static std::size_t _current() {
+        int cpu = sched_getcpu();
+        if (cpu >= 0) {
+            return std::size_t(cpu);
+        }
+        return std::hash<std::thread::id>()(std::this_thread::get_id());
+    }
+
+    std::size_t _size;
+    slot *_slots;
+};
 
 } // namespace Concurrency
 } // namespace Afina
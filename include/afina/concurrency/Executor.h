@@ -1,21 +1,40 @@
 #ifndef AFINA_CONCURRENCY_EXECUTOR_H
 #define AFINA_CONCURRENCY_EXECUTOR_H
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include <afina/concurrency/WorkStealingDeque.h>
 
 namespace Afina {
 namespace Concurrency {
 
 /**
  * # Thread pool
+ * Work stealing pool: each thread has own deque of tasks, tasks submitted from the pool threads go
+ * to the deque of the submitting thread and never touch shared state. Tasks submitted from outside
+ * go to the global injection queue. Thread that runs out of tasks takes them from the injection
+ * queue and then steals from the other threads deques.
+ *
+ * Idle thread spins for a while before going to sleep, so bursts of short tasks don't pay for
+ * wakeups. Pool starts with min_threads and adds threads up to max_threads while all existing
+ * ones are busy. Thread above min_threads exits once it was idle for idle_timeout.
+ *
+ * Queue could be bounded by max_queue tasks, what happens with tasks above the limit is defined by
+ * RejectPolicy.
  */
 class Executor {
+public:
     enum class State {
         // Threadpool is fully operational, tasks could be added and get executed
         kRun,
@@ -28,14 +47,68 @@ class Executor {
         kStopped
     };
 
+    /**
+     * What to do with task submitted while queue is full
+     */
+    enum class RejectPolicy {
+        // Execute returns false immediately
+        kReject,
+
+        // Task is executed by the thread calling Execute
+        kCallerRuns,
+
+        // Execute waits for free space up to block_timeout and returns false if there is still
+        // no space. Pool threads never wait, tasks they submit are executed in place instead
+        kBlock
+    };
+
+    /**
+     * Counters of the pool
+     */
+    struct Stats {
+        // Number of tasks placed into queue
+        uint64_t queued;
+
+        // Number of tasks rejected because queue was full
+        uint64_t rejected;
+
+        // Number of tasks executed by submitter because queue was full
+        uint64_t caller_runs;
+
+        // Number of tasks in queue at the moment, tracked only if queue is bounded
+        std::size_t in_queue;
+    };
+
+    /**
+     * Pool of fixed number of threads
+     */
     Executor(std::string name, int size);
+
+    /**
+     * @param name prefix of threads names
+     * @param min_threads number of threads kept alive even if there is nothing to do
+     * @param max_threads maximum number of threads, must be positive and not less than min_threads
+     * @param idle_timeout how long thread above min_threads waits for tasks before exit
+     * @param max_queue maximum number of tasks waiting for execution, 0 for unbounded queue
+     * @param policy what to do with tasks above max_queue
+     * @param block_timeout how long Execute waits for free space if policy is kBlock
+     */
+    Executor(std::string name, std::size_t min_threads, std::size_t max_threads,
+             std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(1000), std::size_t max_queue = 0,
+             RejectPolicy policy = RejectPolicy::kReject,
+             std::chrono::milliseconds block_timeout = std::chrono::milliseconds(0));
+
+    /**
+     * Stops pool and waits for all tasks to complete
+     */
     ~Executor();
 
     /**
      * Signal thread pool to stop, it will stop accepting new jobs and close threads just after each become
      * free. All enqueued jobs will be complete.
      *
-     * In case if await flag is true, call won't return until all background jobs are done and all threads are stopped
+     * In case if await flag is true, call won't return until all background jobs are done and all threads are stopped.
+     * Must not be called with await flag from the pool threads
      */
     void Stop(bool await = false);
 
@@ -47,31 +120,101 @@ class Executor {
      * execution finished by itself
      */
     template <typename F, typename... Types> bool Execute(F &&func, Types... args) {
-        // Prepare "task"
-        auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
-
-        std::unique_lock<std::mutex> lock(this->mutex);
-        if (state != State::kRun) {
+        if (state.load(std::memory_order_acquire) != State::kRun) {
             return false;
         }
 
-        // Enqueue new task
-        tasks.push_back(exec);
-        empty_condition.notify_one();
-        return true;
+        // Prepare "task"
+        std::unique_ptr<task> exec(new task(std::bind(std::forward<F>(func), std::forward<Types>(args)...)));
+        return Submit(exec);
     }
 
+    /**
+     * Current number of threads in the pool
+     */
+    std::size_t Threads() const { return threads_count.load(std::memory_order_relaxed); }
+
+    State GetState() const { return state.load(std::memory_order_acquire); }
+
+    Stats GetStats() const;
+
 private:
+    using task = std::function<void()>;
+
+    // Pool thread and its tasks
+    struct worker {
+        // Tasks submitted from this thread, owned by it
+        WorkStealingDeque<task *> tasks;
+
+        // Thread currently or previously running in this slot
+        std::thread thread;
+
+        // Slot is occupied by running thread, guarded by mutex
+        bool active = false;
+    };
+
     // No copy/move/assign allowed
     Executor(const Executor &);            // = delete;
     Executor(Executor &&);                 // = delete;
     Executor &operator=(const Executor &); // = delete;
     Executor &operator=(Executor &&);      // = delete;
 
+    /**
+     * Places task into the queue and wakes up or starts thread to run it. Takes ownership of the
+     * task on success
+     */
+    bool Submit(std::unique_ptr<task> &exec);
+
+    /**
+     * Takes place in the bounded queue, waits for it if allowed. Returns false if there is no space
+     */
+    bool Reserve(bool may_block);
+
+    /**
+     * Wakes up sleeping thread or starts new one if everybody is busy
+     */
+    void Wake();
+
+    /**
+     * Finds next task for the given pool thread: own deque first, then injection queue, then
+     * other threads deques. Returns nullptr if there is nothing to do
+     */
+    task *Take(std::size_t idx);
+    task *TakeQueued(std::size_t idx);
+
+    /**
+     * Any task is queued somewhere
+     */
+    bool HasTasks() const;
+
+    /**
+     * Starts new thread if there is a free slot, mutex must be held
+     */
+    void Spawn();
+
     /**
      * Main function that all pool threads are running. It polls internal task queue and execute tasks
      */
-    friend void perform(Executor *executor);
+    friend void perform(Executor *executor, std::size_t idx);
+
+    /**
+     * Pool name, used as threads names prefix
+     */
+    std::string name;
+
+    /**
+     * Threads pool limits
+     */
+    std::size_t min_threads;
+    std::size_t max_threads;
+    std::chrono::milliseconds idle_timeout;
+
+    /**
+     * Queue limits
+     */
+    std::size_t max_queue;
+    RejectPolicy policy;
+    std::chrono::milliseconds block_timeout;
 
     /**
      * Mutex to protect state below from concurrent modification
@@ -84,19 +227,67 @@ private:
     std::condition_variable empty_condition;
 
     /**
-     * Vector of actual threads that perorm execution
+     * Conditional variable to await free space in the bounded queue
+     */
+    std::condition_variable space_condition;
+
+    /**
+     * Signaled once the last thread exits on stop
+     */
+    std::condition_variable stop_condition;
+
+    /**
+     * Slot for each possible thread, size is max_threads and never changes
+     */
+    std::vector<std::unique_ptr<worker>> workers;
+
+    /**
+     * Number of running threads
+     */
+    std::atomic<std::size_t> threads_count;
+
+    /**
+     * Number of threads looking for work, either spinning or sleeping
+     */
+    std::atomic<std::size_t> idle_count;
+
+    /**
+     * Number of threads sleeping on empty_condition
+     */
+    std::atomic<std::size_t> sleeping_count;
+
+    /**
+     * Tasks submitted from outside of the pool
+     */
+    std::mutex injection_mutex;
+    std::deque<task *> injection;
+
+    /**
+     * Size of injection queue, allows to skip locking when it is empty
+     */
+    std::atomic<std::size_t> injection_size;
+
+    /**
+     * Number of tasks in queue, tracked if queue is bounded
+     */
+    std::atomic<std::size_t> queue_size;
+
+    /**
+     * Number of submitters waiting on space_condition
      */
-    std::vector<std::thread> threads;
+    std::atomic<std::size_t> blocked_count;
 
     /**
-     * Task queue
+     * See Stats
      */
-    std::deque<std::function<void()>> tasks;
+    std::atomic<uint64_t> queued_total;
+    std::atomic<uint64_t> rejected_total;
+    std::atomic<uint64_t> caller_runs_total;
 
     /**
      * Flag to stop bg threads
      */
-    State state;
+    std::atomic<State> state;
 };
 
 } // namespace Concurrency
@@ -1,10 +1,179 @@
 #ifndef AFINA_CONCURRENCY_FLAT_COMBINE_H
 #define AFINA_CONCURRENCY_FLAT_COMBINE_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <new>
+#include <thread>
+#include <utility>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename Op> class FlatCombine {};
+/**
+ * # Flat combining
+ * Serializes operations on a sequential data structure without making every thread take the
+ * lock. Thread publishes pointer to its operation in a slot of the publication array and then
+ * either waits for somebody to execute it or becomes the combiner itself. Combiner collects all
+ * published operations and applies them one after another, so the structure stays in its cache and
+ * there is just one lock handoff per batch instead of one per operation.
+ *
+ * Op is a user defined description of operation including place for its result. Apply function
+ * executes a single operation and is always called by one thread at a time. Exception thrown by it
+ * is rethrown from Execute of the thread owning the operation, other operations of the batch are
+ * not affected.
+ *
+ * See "Flat Combining and the Synchronization-Parallelism Tradeoff", D. Hendler et al, SPAA'10
+ */
+template <typename Op> class FlatCombine {
+public:
+    using apply_func = std::function<void(Op &op)>;
+
+    /**
+     * @param apply function applying single operation
+     * @param slots size of publication array, more threads than slots only cause extra spinning
+     */
+    FlatCombine(apply_func apply, std::size_t slots = 64) : _apply(apply), _n_slots(slots), _lock(false) {
+        // Operator new doesn't respect alignment above the fundamental one in C++11
+        void *memory = nullptr;
+        if (posix_memalign(&memory, kCacheLine, slots * sizeof(slot)) != 0) {
+            throw std::bad_alloc();
+        }
+        _slots = static_cast<slot *>(memory);
+        for (std::size_t i = 0; i < slots; i++) {
+            new (&_slots[i]) slot();
+            _slots[i].state.store(kFree, std::memory_order_relaxed);
+        }
+    }
+
+    ~FlatCombine() {
+        for (std::size_t i = 0; i < _n_slots; i++) {
+            _slots[i].~slot();
+        }
+        free(_slots);
+    }
+
+    /**
+     * Publishes operation and returns once it is applied
+     */
+    void Execute(Op &op) {
+        slot &s = _publish(op);
+        for (unsigned spins = 0; s.state.load(std::memory_order_acquire) != kDone; spins++) {
+            if (_try_combine()) {
+                continue;
+            }
+
+            // Combiner is somebody else, most likely it picks the operation in its next pass
+            if (spins > 64) {
+                std::this_thread::yield();
+            }
+        }
+
+        // Slot is released only after result is taken, so nobody else could overwrite the error
+        std::exception_ptr error;
+        std::swap(error, s.error);
+        s.state.store(kFree, std::memory_order_release);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    FlatCombine(const FlatCombine &) = delete;
+    FlatCombine &operator=(const FlatCombine &) = delete;
+
+    // Slot life cycle: publisher claims free slot and publishes operation in it, combiner applies
+    // published operation and marks it done, owner takes the result and frees the slot. Each side
+    // touches the slot only in its own states
+    enum : int { kFree, kClaimed, kPublished, kDone };
+
+    static const std::size_t kCacheLine = 64;
+
+    // Publication record, occupies whole cache line so that waiting threads don't disturb each other
+    struct alignas(kCacheLine) slot {
+        std::atomic<int> state;
+
+        // Operation of the owner, valid since kPublished
+        Op *op;
+
+        // What operation has thrown, written by combiner before kDone
+        std::exception_ptr error;
+    };
+    static_assert(sizeof(slot) == kCacheLine, "Publication record must take exactly one cache line");
+
+    // Releases combiner lock however combining ends
+    struct unlock_guard {
+        std::atomic<bool> &lock;
+        ~unlock_guard() { lock.store(false, std::memory_order_release); }
+    };
+
+    // Takes free slot starting from the one preferred by the current thread
+    slot &_publish(Op &op) {
+        std::size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % _n_slots;
+        for (;;) {
+            for (std::size_t i = 0; i < _n_slots; i++) {
+                slot &s = _slots[(start + i) % _n_slots];
+                int expected = kFree;
+                if (s.state.load(std::memory_order_relaxed) == kFree &&
+                    s.state.compare_exchange_strong(expected, kClaimed, std::memory_order_acquire,
+                                                    std::memory_order_relaxed)) {
+                    s.op = &op;
+                    s.state.store(kPublished, std::memory_order_release);
+                    return s;
+                }
+            }
+
+            // All slots are busy, help to drain them
+            if (!_try_combine()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Becomes combiner if nobody else is and applies all published operations. Returns false
+    // if combiner lock is held by another thread
+    bool _try_combine() {
+        if (_lock.load(std::memory_order_relaxed) || _lock.exchange(true, std::memory_order_acquire)) {
+            return false;
+        }
+        unlock_guard guard{_lock};
+
+        // A few passes let operations published while batch was running join without lock handoff
+        for (int pass = 0; pass < 3; pass++) {
+            bool found = false;
+            for (std::size_t i = 0; i < _n_slots; i++) {
+                slot &s = _slots[i];
+                if (s.state.load(std::memory_order_acquire) != kPublished) {
+                    continue;
+                }
+
+                found = true;
+                try {
+                    _apply(*s.op);
+                } catch (...) {
+                    s.error = std::current_exception();
+                }
+                s.state.store(kDone, std::memory_order_release);
+            }
+            if (!found) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    apply_func _apply;
+
+    // Publication array, aligned on cache line
+    slot *_slots;
+    std::size_t _n_slots;
+
+    // Combiner lock
+    std::atomic<bool> _lock;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -1,10 +1,136 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * Non template part of ThreadLocal: instance ids and per thread table of values
+ */
+class ThreadLocalBase {
+protected:
+    // Values of all threads, shared by ThreadLocal and threads that hold its values
+    struct registry {
+        virtual ~registry() {}
+
+        // Called on exit of the thread owning the value
+        virtual void release(void *value) = 0;
+
+        std::mutex mutex;
+    };
+
+    ThreadLocalBase();
+
+    /**
+     * Value of the instance with given id for the current thread, nullptr if there is none yet
+     */
+    static void *_lookup(std::size_t id);
+
+    /**
+     * Remembers value of the current thread, registry gets released on thread exit unless it is
+     * destroyed earlier
+     */
+    static void _attach(std::size_t id, std::shared_ptr<registry> owner, void *value);
+
+    // Unique id of the instance, index in per thread table. Ids are never reused, so stale
+    // entries left by destroyed instances are never looked at again
+    const std::size_t _id;
+};
+
+/**
+ * # Per thread storage
+ * Like thread_local variable, but an object member rather than a static one and all threads values
+ * could be visited. Value is created by the first get() in each thread and lives until the thread
+ * exits or ThreadLocal is destroyed, whatever happens first. Access from the owning thread doesn't
+ * take locks and doesn't allocate after the first call.
+ *
+ * Values are visited under the registry lock, which is taken only on thread start/exit besides
+ * that. Owner keeps working with its value while it is being visited, so fields that are read
+ * across threads must be atomics.
+ *
+ * Exit function is called when thread exits with the value about to be destroyed, it allows
+ * to fold counters of gone threads into some totals. It is called under the registry lock and must
+ * not touch the ThreadLocal itself.
+ */
+template <typename T> class ThreadLocal : public ThreadLocalBase {
+public:
+    using exit_func = std::function<void(T &)>;
+
+    explicit ThreadLocal(exit_func on_exit = nullptr) : _values(std::make_shared<values>(std::move(on_exit))) {}
+
+    /**
+     * Destroys values of all threads, must not race with their use
+     */
+    ~ThreadLocal() {}
+
+    /**
+     * Value of the current thread
+     */
+    T &get() {
+        void *value = _lookup(_id);
+        if (value != nullptr) {
+            return *static_cast<T *>(value);
+        }
+        return _create();
+    }
+
+    T &operator*() { return get(); }
+    T *operator->() { return &get(); }
+
+    /**
+     * Calls function for value of each live thread
+     */
+    template <typename F> void for_each(F func) {
+        std::lock_guard<std::mutex> lock(_values->mutex);
+        for (auto &value : _values->items) {
+            func(*value);
+        }
+    }
+
+private:
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    struct values : public registry {
+        explicit values(exit_func on_exit) : on_exit(std::move(on_exit)) {}
+
+        void release(void *value) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = std::find_if(items.begin(), items.end(),
+                                   [value](const std::unique_ptr<T> &item) { return item.get() == value; });
+            if (it == items.end()) {
+                return;
+            }
+            if (on_exit) {
+                on_exit(**it);
+            }
+            items.erase(it);
+        }
+
+        exit_func on_exit;
+        std::vector<std::unique_ptr<T>> items;
+    };
+
+    T &_create() {
+        std::unique_ptr<T> item(new T());
+        T *value = item.get();
+        {
+            std::lock_guard<std::mutex> lock(_values->mutex);
+            _values->items.push_back(std::move(item));
+        }
+        _attach(_id, _values, value);
+        return *value;
+    }
+
+    std::shared_ptr<values> _values;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,151 @@
+#ifndef AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
+#define AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Chase-Lev work stealing deque
+ * Single owner thread pushes and pops items at the bottom end, any other thread could steal
+ * items from the top end. Neither operation takes locks: owner synchronizes with thieves only
+ * when the deque is about to become empty, thieves compete with each other by CAS on top.
+ *
+ * Buffer grows when full. Replaced buffers are kept until the deque is destroyed, because a slow
+ * thief might still read from them.
+ *
+ * T must be trivially copyable, usually it is a pointer.
+ *
+ * See "Correct and Efficient Work-Stealing for Weak Memory Models", N.M. Le et al, PPoPP'13
+ */
+template <typename T> class WorkStealingDeque {
+public:
+    /**
+     * @param capacity initial capacity, rounded up to power of 2
+     */
+    explicit WorkStealingDeque(std::size_t capacity = 64) : _top(0), _bottom(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _buffers.emplace_back(new buffer(size));
+        _buffer.store(_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    /**
+     * Adds item at the bottom. Owner thread only
+     */
+    void push(T item) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        buffer *a = _buffer.load(std::memory_order_relaxed);
+        if (b - t > int64_t(a->mask)) {
+            a = _grow(a, t, b);
+        }
+
+        // Release store instead of the fence in the paper: the same cost on x86 and visible to
+        // race detectors
+        a->put(b, item);
+        _bottom.store(b + 1, std::memory_order_release);
+    }
+
+    /**
+     * Takes the most recently pushed item. Owner thread only. Returns false if deque is empty
+     */
+    bool pop(T &item) {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        buffer *a = _buffer.load(std::memory_order_relaxed);
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = a->get(b);
+        if (t < b) {
+            return true;
+        }
+
+        // The last item, race against thieves for it
+        bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    /**
+     * Takes the least recently pushed item. Could be called by any thread. Returns false if
+     * deque is empty or another thread has taken the item concurrently
+     */
+    bool steal(T &item) {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+
+        buffer *a = _buffer.load(std::memory_order_acquire);
+        item = a->get(t);
+        return _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    /**
+     * Approximate check, exact only for the owner thread when there are no thieves
+     */
+    bool empty() const {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        return t >= b;
+    }
+
+private:
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    // Circular array of items, accessed by absolute index
+    struct buffer {
+        explicit buffer(std::size_t size) : mask(size - 1), items(new std::atomic<T>[size]) {}
+
+        inline T get(int64_t i) const { return items[i & mask].load(std::memory_order_relaxed); }
+        inline void put(int64_t i, T item) { items[i & mask].store(item, std::memory_order_relaxed); }
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+    buffer *_grow(buffer *a, int64_t t, int64_t b) {
+        _buffers.emplace_back(new buffer((a->mask + 1) * 2));
+        buffer *bigger = _buffers.back().get();
+        for (int64_t i = t; i < b; i++) {
+            bigger->put(i, a->get(i));
+        }
+        _buffer.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    // Index of the oldest item, thieves take from here
+    std::atomic<int64_t> _top;
+
+    // Index past the newest item, owner pushes and pops here
+    std::atomic<int64_t> _bottom;
+
+    // Current buffer
+    std::atomic<buffer *> _buffer;
+
+    // All buffers ever used, the last one is current. Owner thread only
+    std::vector<std::unique_ptr<buffer>> _buffers;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
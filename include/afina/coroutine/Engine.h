@@ -1,25 +1,71 @@
 #ifndef AFINA_COROUTINE_ENGINE_H
 #define AFINA_COROUTINE_ENGINE_H
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <new>
 #include <tuple>
+#include <type_traits>
 
 #include <setjmp.h>
 
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
 namespace Afina {
 namespace Coroutine {
 
 /**
  * # Entry point of coroutine library
  * Allows to run coroutine and schedule its execution. Not threadsafe
+ *
+ * Engine works in one of two modes:
+ * - StackCopy: all coroutines run on the stack of the thread called start(). On each switch the live part
+ *   of the stack is copied out of the current coroutine and copied in for the next one. Doesn't need any
+ *   memory upfront, but the cost of switch grows with depth of the stack
+ * - FixedStack: each coroutine gets own stack mapped with a guard page below it, so overflow crashes
+ *   instead of corrupting memory. Switch only saves and restores registers
  */
 class Engine final {
 public:
     using unblocker_func = std::function<void(Engine &)>;
 
+    enum class StackMode { StackCopy, FixedStack };
+
+    /**
+     * Default size of coroutine stack in FixedStack mode
+     */
+    static const std::size_t kDefaultStackSize = 64 * 1024;
+
+    /**
+     * Default number of finished coroutines contexts kept for reuse
+     */
+    static const std::size_t kDefaultMaxPooled = 256;
+
+    /**
+     * Counters of coroutines contexts. Context includes stack: mapped one in FixedStack mode or buffer
+     * for stack copy in StackCopy mode
+     */
+    struct Stats {
+        // Number of contexts ever created
+        std::size_t created;
+
+        // Number of coroutines started on recycled context
+        std::size_t reused;
+
+        // Number of contexts used by coroutines right now and the highest value it ever had
+        std::size_t in_use;
+        std::size_t in_use_max;
+
+        // Number of contexts waiting in the pool for reuse and the highest value it ever had
+        std::size_t pooled;
+        std::size_t pooled_max;
+    };
+
 private:
     /**
      * A single coroutine instance which could be scheduled for execution
@@ -42,8 +88,83 @@ private:
         // To include routine in the different lists, such as "alive", "blocked", e.t.c
         struct context *prev = nullptr;
         struct context *next = nullptr;
+
+        // Routine is in the "blocked" list
+        bool Blocked = false;
+
+        // FixedStack mode: function to run. Small functions are stored right here, so starting coroutine
+        // on a recycled context doesn't allocate
+        alignas(16) char Body[64];
+        void (*BodyCall)(void *) = nullptr;
+        void (*BodyDestroy)(void *) = nullptr;
+
+        // FixedStack mode: mapped stack including guard page
+        char *Mapped = nullptr;
+        std::size_t MappedSize = 0;
+
+        // FixedStack mode: saved stack pointer, registers are stored on the stack itself
+        void *Sp = nullptr;
+
+#if !defined(__x86_64__)
+        // FixedStack mode: saved context on platforms without own switch routine
+        ucontext_t Ucontext;
+#endif
     } context;
 
+    // Coroutine arguments are kept as is if function takes them by reference and copied otherwise
+    template <typename T> struct bound_arg {
+        using type = typename std::conditional<std::is_lvalue_reference<T>::value,
+                                               std::reference_wrapper<typename std::remove_reference<T>::type>,
+                                               typename std::decay<T>::type>::type;
+    };
+
+    // Type erased function stored in context::Body
+    template <typename F, bool Inline = (sizeof(F) <= sizeof(context::Body))> struct body {
+        static void set(context &ctx, F &&func) {
+            new (ctx.Body) F(std::move(func));
+            ctx.BodyCall = [](void *p) { (*static_cast<F *>(p))(); };
+            ctx.BodyDestroy = [](void *p) { static_cast<F *>(p)->~F(); };
+        }
+    };
+    template <typename F> struct body<F, false> {
+        static void set(context &ctx, F &&func) {
+            *reinterpret_cast<F **>(ctx.Body) = new F(std::move(func));
+            ctx.BodyCall = [](void *p) { (**static_cast<F **>(p))(); };
+            ctx.BodyDestroy = [](void *p) { delete *static_cast<F **>(p); };
+        }
+    };
+
+    /**
+     * How coroutines stacks are managed
+     */
+    StackMode _mode;
+
+    /**
+     * Size of coroutine stack in FixedStack mode, without guard page
+     */
+    std::size_t _stack_size;
+
+    /**
+     * Finished contexts ready for reuse, linked through next
+     */
+    context *_pool;
+
+    /**
+     * Maximum number of contexts in _pool, contexts above that are released
+     */
+    std::size_t _max_pooled;
+
+    /**
+     * See Stats
+     */
+    Stats _stats;
+
+    /**
+     * FixedStack mode: routine completed and waiting for its context to be released. Routine can't
+     * give away the stack it is running on, so it is done by the next one
+     */
+    context *_finished;
+
     /**
      * Where coroutines stack begins
      */
@@ -85,14 +206,93 @@ protected:
      */
     void Restore(context &ctx);
 
+    /**
+     * Pass control to the given context, saving the current one. If the given context is idle_ctx then
+     * control goes back to start()
+     */
+    void Enter(context *ctx);
+
+    /**
+     * FixedStack mode: map stack for the given context unless it has one already and prepare it to start
+     * Body. Returns false if there is no memory for stack
+     */
+    bool Prepare(context &ctx);
+
+    /**
+     * FixedStack mode: switch stacks, saving current registers into from
+     */
+    void Switch(context &from, context &to);
+
+    /**
+     * FixedStack mode: releases context of the finished routine, if any
+     */
+    void Reap();
+
+    /**
+     * FixedStack mode: scheduling loop of start(), runs until there are no alive coroutines
+     */
+    void Idle();
+
+    /**
+     * FixedStack mode: first function running on the new stack
+     */
+    static void Entry(Engine *engine);
+
+#if !defined(__x86_64__)
+    /**
+     * FixedStack mode: makecontext passes only int arguments, so engine pointer is split in two halves
+     */
+    static void UcontextEntry(unsigned int hi, unsigned int lo);
+#endif
+
+    /**
+     * Takes context from the pool or creates new one
+     */
+    context *Acquire();
+
+    /**
+     * Returns context of the finished coroutine to the pool
+     */
+    void Release(context *ctx);
+
+    /**
+     * Releases context and its stack
+     */
+    void Free(context *ctx);
+
     static void null_unblocker(Engine &) {}
 
 public:
-    Engine(unblocker_func unblocker = null_unblocker)
-        : StackBottom(0), cur_routine(nullptr), alive(nullptr), _unblocker(unblocker) {}
+    /**
+     * @param unblocker function to call when all coroutines are blocked
+     * @param mode how coroutines stacks are managed
+     * @param stack_size size of each coroutine stack in FixedStack mode
+     * @param max_pooled how many contexts of finished coroutines keep for reuse
+     */
+    Engine(unblocker_func unblocker = null_unblocker, StackMode mode = StackMode::StackCopy,
+           std::size_t stack_size = kDefaultStackSize, std::size_t max_pooled = kDefaultMaxPooled)
+        : _mode(mode), _stack_size(stack_size), _pool(nullptr), _max_pooled(max_pooled), _stats(), _finished(nullptr),
+          StackBottom(0), cur_routine(nullptr), alive(nullptr), blocked(nullptr), idle_ctx(nullptr),
+          _unblocker(unblocker) {}
     Engine(Engine &&) = delete;
     Engine(const Engine &) = delete;
 
+    /**
+     * Releases coroutines that never finished, for example still blocked when start() returned
+     */
+    ~Engine();
+
+    /**
+     * Contexts pool counters
+     */
+    Stats GetStats() const { return _stats; }
+
+    /**
+     * Currently running coroutine, nullptr if called outside of coroutines. Allows routine to pass itself
+     * to whoever is going to unblock it
+     */
+    void *current() const { return cur_routine; }
+
     /**
      * Gives up current routine execution and let engine to schedule other one. It is not defined when
      * routine will get execution back, for example if there are no other coroutines then executing could
@@ -144,7 +344,11 @@ public:
         void *pc = run(main, std::forward<Ta>(args)...);
 
         idle_ctx = new context();
-        if (setjmp(idle_ctx->Environment) > 0) {
+        if (_mode == StackMode::FixedStack) {
+            if (pc != nullptr) {
+                Idle();
+            }
+        } else if (setjmp(idle_ctx->Environment) > 0) {
             if (alive == nullptr) {
                 _unblocker(*this);
             }
@@ -163,7 +367,7 @@ public:
 
     /**
      * Register new coroutine. It won't receive control until scheduled explicitely or implicitly. In case of some
-     * errors function returns -1
+     * errors, for example no memory for stack, function returns nullptr
      */
     template <typename... Ta> void *run(void (*func)(Ta...), Ta &&... args) {
         if (this->StackBottom == 0) {
@@ -172,7 +376,24 @@ public:
         }
 
         // New coroutine context that carries around all information enough to call function
-        context *pc = new context();
+        context *pc = Acquire();
+
+        if (_mode == StackMode::FixedStack) {
+            // Routine starts from the beginning of its own stack, so all it needs is the function and arguments
+            auto bound = std::bind(func, typename bound_arg<Ta>::type(std::forward<Ta>(args))...);
+            body<decltype(bound)>::set(*pc, std::move(bound));
+            if (!Prepare(*pc)) {
+                Release(pc);
+                return nullptr;
+            }
+
+            pc->next = alive;
+            alive = pc;
+            if (pc->next != nullptr) {
+                pc->next->prev = pc;
+            }
+            return pc;
+        }
 
         // Store current state right here, i.e just before enter new coroutine, later, once it gets scheduled
         // execution starts here. Note that we have to acquire stack of the current function call to ensure
@@ -203,8 +424,7 @@ public:
             // current coroutine finished, and the pointer is not relevant now
             cur_routine = nullptr;
             pc->prev = pc->next = nullptr;
-            delete std::get<0>(pc->Stack);
-            delete pc;
+            Release(pc);
 
             // We cannot return here, as this function "returned" once already, so here we must select some other
             // coroutine to run. As current coroutine is completed and can't be scheduled anymore, it is safe to
@@ -0,0 +1,168 @@
+#ifndef AFINA_COROUTINE_EPOLL_H
+#define AFINA_COROUTINE_EPOLL_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <afina/coroutine/Engine.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Blocking style IO for coroutines
+ * Socket operations that look like blocking ones for the calling coroutine: if socket isn't ready the
+ * coroutine gets blocked in the engine until epoll reports readiness. Poll must be used as the engine
+ * unblocker, so epoll is waited on only once all coroutines are blocked:
+ *
+ *     Epoll io;
+ *     Engine engine([&io](Engine &e) { io.Poll(e); });
+ *
+ * Descriptors must be non blocking. Each one is added to epoll edge triggered on the first use and stays
+ * there until co_close. At most one coroutine could read and one could write the same descriptor at once.
+ *
+ * Each operation accepts optional deadline. Pending deadlines are kept in a heap and the nearest one is
+ * passed to epoll_wait as timeout, so timeouts cost no syscalls. Operation not completed by its deadline
+ * fails with ETIMEDOUT.
+ */
+class Epoll {
+public:
+    using clock = std::chrono::steady_clock;
+
+    Epoll();
+    ~Epoll();
+
+    /**
+     * Waits for the registered descriptors and the nearest deadline and unblocks coroutines that could
+     * continue. Returns without waiting if no coroutine waits for IO or time
+     */
+    void Poll(Engine &engine);
+
+    /**
+     * Reads up to count bytes, blocking the coroutine until there is something to read. Returns the
+     * same as read(2)
+     */
+    ssize_t co_read(Engine &engine, int fd, void *buf, std::size_t count,
+                    clock::time_point deadline = clock::time_point::max());
+
+    /**
+     * Writes all count bytes, blocking the coroutine while socket buffer is full. Returns count or -1 on
+     * error, in that case some prefix of data could be sent already
+     */
+    ssize_t co_write(Engine &engine, int fd, const void *buf, std::size_t count,
+                     clock::time_point deadline = clock::time_point::max());
+
+    /**
+     * Accepts new connection, blocking the coroutine until there is one. Accepted socket is non blocking.
+     * Returns the same as accept(2)
+     */
+    int co_accept(Engine &engine, int fd, struct sockaddr *addr, socklen_t *addrlen,
+                  clock::time_point deadline = clock::time_point::max());
+
+    /**
+     * Forgets descriptor and closes it. Nobody must wait for the descriptor at that moment
+     */
+    void co_close(int fd);
+
+    /**
+     * Blocks the coroutine until the given time
+     */
+    void sleep_until(Engine &engine, clock::time_point deadline);
+
+    /**
+     * Blocks the coroutine for the given time
+     */
+    template <typename Rep, typename Period> void sleep_for(Engine &engine, std::chrono::duration<Rep, Period> time) {
+        sleep_until(engine, clock::now() + std::chrono::duration_cast<clock::duration>(time));
+    }
+
+    /**
+     * Number of coroutines blocked on IO or sleep
+     */
+    std::size_t Waiting() const { return _waiting; }
+
+private:
+    Epoll(const Epoll &) = delete;
+    Epoll &operator=(const Epoll &) = delete;
+
+    // Coroutines waiting for the descriptor
+    struct waiters {
+        bool registered = false;
+        void *reader = nullptr;
+        void *writer = nullptr;
+    };
+
+    // Deadline of the blocked coroutine. Records live in Epoll rather than on the coroutine stack, which
+    // is saved and overwritten by other coroutines in StackCopy mode while the coroutine is blocked
+    struct timer {
+        clock::time_point deadline;
+        void *routine;
+
+        // Descriptor coroutine waits for, -1 for sleep
+        int fd;
+        bool write;
+
+        // Position in _timers, kNotQueued once removed. Free records are linked through it
+        std::size_t index;
+
+        // Deadline passed before operation completed
+        bool fired;
+    };
+
+    static const std::size_t kNotQueued = std::size_t(-1);
+
+    /**
+     * Takes free timer record and fills it, returns its handle
+     */
+    std::size_t _new_timer(clock::time_point deadline, void *routine, int fd, bool write);
+
+    /**
+     * Returns record back, it must not be queued
+     */
+    void _free_timer(std::size_t t);
+
+    /**
+     * Adds descriptor to epoll unless it is there already
+     */
+    void _watch(int fd);
+
+    /**
+     * Blocks current coroutine until Poll reports descriptor is ready for reading or writing. Returns false
+     * if deadline passed first
+     */
+    bool _wait(Engine &engine, int fd, bool write, clock::time_point deadline);
+
+    /**
+     * Unblocks coroutines which deadlines passed
+     */
+    bool _expire(Engine &engine);
+
+    // Binary min heap on deadline, timers are referenced by handles
+    void _push(std::size_t t);
+    void _remove(std::size_t t);
+    void _sift_up(std::size_t i);
+    void _sift_down(std::size_t i);
+
+    int _epoll_fd;
+
+    // Indexed by descriptor
+    std::vector<waiters> _fds;
+
+    // Timer records indexed by handle and list of free ones
+    std::vector<timer> _timer_pool;
+    std::size_t _free_timers;
+
+    // Pending deadlines
+    std::vector<std::size_t> _timers;
+
+    std::size_t _waiting;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_EPOLL_H
@@ -9,6 +9,8 @@ class Storage;
 
 namespace Execute {
 
+class Response;
+
 /**
  *
  *
@@ -19,6 +21,13 @@ public:
     virtual ~Command() {}
 
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * Executes command and appends its response including the final "\r\n" to the given builder.
+     * Default implementation copies result of the string version, commands sending values back
+     * override it to reference values instead of copying them
+     */
+    virtual void Execute(Storage &storage, const std::string &args, Response &out);
 };
 
 } // namespace Execute
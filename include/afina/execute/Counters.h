@@ -0,0 +1,48 @@
+#ifndef AFINA_EXECUTE_COUNTERS_H
+#define AFINA_EXECUTE_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/concurrency/CoreLocal.h>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Commands counters
+ * Process wide statistics of executed commands. Counters are kept per core and updated with relaxed
+ * atomics, so workers running on different cores don't share any cache line on the hot path. Values
+ * are summed only when somebody asks for them
+ */
+struct Counters {
+    // Number of keys requested by get commands
+    std::atomic<uint64_t> gets{0};
+
+    // Number of requested keys found in storage
+    std::atomic<uint64_t> hits{0};
+
+    // Number of requested keys not found in storage
+    std::atomic<uint64_t> misses{0};
+
+    // Total size of values sent back by get commands, reported as get_bytes
+    std::atomic<uint64_t> bytes{0};
+
+    /**
+     * Counters instance of the current core
+     */
+    static Counters &local();
+
+    /**
+     * Appends sum over all cores to the given list, names follow memcached "stats" output
+     */
+    static void Collect(std::vector<std::pair<std::string, std::string>> &stats);
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_COUNTERS_H
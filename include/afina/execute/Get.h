@@ -1,6 +1,7 @@
 #ifndef AFINA_EXECUTE_GET_H
 #define AFINA_EXECUTE_GET_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -41,7 +42,15 @@ public:
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
+    /**
+     * Values are referenced by response, only headers get copied
+     */
+    void Execute(Storage &storage, const std::string &args, Response &out) override;
+
 private:
+    // Updates counters of the current core
+    void Count(uint64_t hits, uint64_t bytes) const;
+
     std::vector<std::string> _keys;
 };
 
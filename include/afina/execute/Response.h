@@ -0,0 +1,101 @@
+#ifndef AFINA_EXECUTE_RESPONSE_H
+#define AFINA_EXECUTE_RESPONSE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Response builder
+ * Queue of bytes to be sent to client, described as a list of segments ready for writev. Small pieces
+ * like status lines and headers are copied into the internal buffer, values are referenced in place
+ * and kept alive by their owner until sent, so large values are never copied on the way to socket.
+ *
+ * Connection keeps one instance for its whole life: commands append to the tail, network layer fills
+ * iovecs from the head and consumes what was written. Buffers keep their capacity once drained.
+ */
+class Response {
+public:
+    Response() : _size(0), _first(0), _first_sent(0) {}
+
+    /**
+     * Copies bytes into the internal buffer
+     */
+    void Append(const char *data, std::size_t size);
+    void Append(const std::string &data) { Append(data.data(), data.size()); }
+
+    /**
+     * Adds bytes without copying them, owner is kept until bytes are consumed
+     */
+    void Reference(const char *data, std::size_t size, std::shared_ptr<const void> owner);
+    void Reference(std::shared_ptr<const std::string> data) { Reference(data->data(), data->size(), data); }
+
+    /**
+     * Number of bytes not consumed yet
+     */
+    inline std::size_t Size() const { return _size; }
+    inline bool Empty() const { return _size == 0; }
+
+    /**
+     * Describes bytes not consumed yet by at most count iovecs, returns number of iovecs filled
+     */
+    std::size_t Fill(struct iovec *iov, std::size_t count) const;
+
+    /**
+     * Drops first bytes of the response, usually the ones written by the last writev
+     */
+    void Consume(std::size_t bytes);
+
+    /**
+     * Drops everything, keeps buffers capacity
+     */
+    void Clear();
+
+    /**
+     * Copies bytes not consumed yet to the end of the given string
+     */
+    void CopyTo(std::string &out) const;
+
+private:
+    // Piece of response: either range of _buffer or bytes held by owner
+    struct segment {
+        // Start of referenced bytes, nullptr for range of _buffer
+        const char *data;
+
+        // Offset of the range in _buffer
+        std::size_t offset;
+
+        std::size_t size;
+
+        // Keeps referenced bytes alive
+        std::shared_ptr<const void> owner;
+    };
+
+    inline const char *_start(const segment &s) const { return s.data != nullptr ? s.data : _buffer.data() + s.offset; }
+
+    // Moves not consumed part to the beginning of buffers once consumed one gets large
+    void _compact();
+
+    // Copied bytes of all segments
+    std::string _buffer;
+
+    std::vector<segment> _segments;
+
+    // See Size
+    std::size_t _size;
+
+    // First segment not consumed completely and how much of it is consumed
+    std::size_t _first;
+    std::size_t _first_sent;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_RESPONSE_H
@@ -1,9 +1,12 @@
 #ifndef AFINA_NETWORK_SERVER_H
 #define AFINA_NETWORK_SERVER_H
 
+#include <chrono>
 #include <memory>
 #include <vector>
 
+#include <sys/socket.h>
+
 namespace Afina {
 class Storage;
 namespace Logging {
@@ -25,8 +28,13 @@ public:
      * Starts network service. After method returns process should
      * listen on the given interface/port pair to process  incomming
      * data in workers number of threads
+     *
+     * @param backlog size of the queue of connections waiting for accept
+     * @param read_timeout connection waiting for client data longer is closed, zero disables timeout.
+     * Event loop servers that don't track idle connections ignore it
      */
-    virtual void Start(uint16_t port, uint32_t acceptors = 1, uint32_t workers = 1) = 0;
+    virtual void Start(uint16_t port, uint32_t acceptors = 1, uint32_t workers = 1, int backlog = SOMAXCONN,
+                       std::chrono::milliseconds read_timeout = std::chrono::milliseconds(5000)) = 0;
 
     /**
      * Signal all worker threads that server is going to shutdown. After method returns
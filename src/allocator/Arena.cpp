@@ -0,0 +1,91 @@
+#include <afina/allocator/Arena.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+// Default huge page size on x86_64 and aarch64
+const size_t kHugePage = 2 * 1024 * 1024;
+
+inline size_t round_up(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+} // namespace
+
+// See Arena.h
+Arena::Arena(size_t size, bool huge_pages) : _base(nullptr), _size(0), _mapped(MAP_FAILED), _mapped_size(0) {
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+
+#ifdef MAP_HUGETLB
+    if (huge_pages) {
+        _mapped_size = round_up(size, kHugePage);
+        _mapped = mmap(nullptr, _mapped_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (_mapped != MAP_FAILED) {
+            _base = _mapped;
+            _size = _mapped_size;
+            _mode = PageMode::HugeTLB;
+            return;
+        }
+    }
+#endif // MAP_HUGETLB
+
+#ifdef MADV_HUGEPAGE
+    if (huge_pages) {
+        // Transparent huge pages are used only for aligned ranges, so map a bit more and
+        // use aligned part of it. Pages are faulted after madvise, otherwise they would be
+        // regular ones
+        _size = round_up(size, kHugePage);
+        _mapped_size = _size + kHugePage;
+        _mapped = mmap(nullptr, _mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (_mapped != MAP_FAILED) {
+            uintptr_t start = round_up(reinterpret_cast<uintptr_t>(_mapped), kHugePage);
+            _base = reinterpret_cast<void *>(start);
+            if (madvise(_base, _size, MADV_HUGEPAGE) == 0) {
+                for (size_t off = 0; off < _size; off += page) {
+                    static_cast<volatile char *>(_base)[off] = 0;
+                }
+                _mode = PageMode::Transparent;
+                return;
+            }
+            munmap(_mapped, _mapped_size);
+        }
+    }
+#endif // MADV_HUGEPAGE
+
+    _size = round_up(size, page);
+    _mapped_size = _size;
+    _mapped = mmap(nullptr, _mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (_mapped == MAP_FAILED) {
+        throw std::runtime_error("Failed to map " + std::to_string(_size) + " bytes: " + std::strerror(errno));
+    }
+    _base = _mapped;
+    _mode = PageMode::Regular;
+}
+
+// See Arena.h
+Arena::~Arena() { munmap(_mapped, _mapped_size); }
+
+// See Arena.h
+const char *Arena::mode_name() const {
+    switch (_mode) {
+    case PageMode::HugeTLB:
+        return "hugetlb";
+    case PageMode::Transparent:
+        return "thp";
+    default:
+        return "4k";
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,157 @@
+#include <afina/allocator/Mempool.h>
+
+#include <stdexcept>
+#include <utility>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+// Layout of the free object. Head of magazine uses all fields, other objects only the link
+// to the next one. Depot link must be the first word, see TaggedStack
+struct free_object {
+    void *depot_next;
+    free_object *next;
+    size_t count;
+};
+
+// First word of each slab links it into the list of slabs owned by the pool
+const size_t kSlabHeader = 8;
+
+} // namespace
+
+// See Mempool.h
+Mempool::Mempool(SlabCache &cache, size_t object_size, size_t magazine_size)
+    : _cache(cache), _object_size(0), _magazine_size(magazine_size), _per_slab(0), _slabs(0),
+      _depot(cache.base()), _owned(cache.base()) {
+    if (object_size < sizeof(free_object)) {
+        object_size = sizeof(free_object);
+    }
+    _object_size = (object_size + 7) & ~size_t(7);
+    _per_slab = (cache.slab_size() - kSlabHeader) / _object_size;
+
+    if (_per_slab == 0 || magazine_size == 0) {
+        throw std::runtime_error("Object doesn't fit into slab");
+    }
+}
+
+// See Mempool.h
+Mempool::~Mempool() {
+    void *slab;
+    while ((slab = _owned.pop()) != nullptr) {
+        _cache.put(slab);
+    }
+}
+
+// See Mempool.h
+void Mempool::_put_magazine(void *head, size_t count) {
+    static_cast<free_object *>(head)->count = count;
+    _depot.push(head);
+}
+
+// See Mempool.h
+void *Mempool::_get_magazine(size_t &count) {
+    void *head = _depot.pop();
+    if (head != nullptr) {
+        count = static_cast<free_object *>(head)->count;
+    }
+    return head;
+}
+
+// See Mempool.h
+void *Mempool::_carve_slab(size_t &count) {
+    char *slab = static_cast<char *>(_cache.get());
+    if (slab == nullptr) {
+        return nullptr;
+    }
+    _owned.push(slab);
+    _slabs.fetch_add(1, std::memory_order_relaxed);
+
+    // Cut objects into magazines from the slab end, so the one with lowest addresses is returned
+    free_object *head = nullptr;
+    size_t in_magazine = 0;
+    for (size_t i = _per_slab; i > 0; i--) {
+        free_object *obj = reinterpret_cast<free_object *>(slab + kSlabHeader + (i - 1) * _object_size);
+        obj->next = head;
+        head = obj;
+        in_magazine++;
+
+        if (in_magazine == _magazine_size && i > 1) {
+            _put_magazine(head, in_magazine);
+            head = nullptr;
+            in_magazine = 0;
+        }
+    }
+
+    count = in_magazine;
+    return head;
+}
+
+// See Mempool.h
+Mempool::ThreadCache::ThreadCache(Mempool &pool)
+    : _pool(pool), _loaded(nullptr), _loaded_count(0), _previous(nullptr), _previous_count(0) {}
+
+// See Mempool.h
+Mempool::ThreadCache::~ThreadCache() {
+    if (_loaded_count > 0) {
+        _pool._put_magazine(_loaded, _loaded_count);
+    }
+    if (_previous_count > 0) {
+        _pool._put_magazine(_previous, _previous_count);
+    }
+}
+
+// See Mempool.h
+void *Mempool::ThreadCache::alloc() {
+    if (_loaded_count == 0) {
+        if (_previous_count > 0) {
+            std::swap(_loaded, _previous);
+            std::swap(_loaded_count, _previous_count);
+        } else if (!_refill()) {
+            return nullptr;
+        }
+    }
+
+    free_object *obj = static_cast<free_object *>(_loaded);
+    _loaded = obj->next;
+    _loaded_count--;
+    return obj;
+}
+
+// See Mempool.h
+void Mempool::ThreadCache::free(void *obj) {
+    if (_loaded_count == _pool._magazine_size) {
+        if (_previous_count == _pool._magazine_size) {
+            _pool._put_magazine(_previous, _previous_count);
+            _previous = nullptr;
+            _previous_count = 0;
+        }
+        std::swap(_loaded, _previous);
+        std::swap(_loaded_count, _previous_count);
+    }
+
+    free_object *head = static_cast<free_object *>(obj);
+    head->next = static_cast<free_object *>(_loaded);
+    _loaded = head;
+    _loaded_count++;
+}
+
+// See Mempool.h
+bool Mempool::ThreadCache::_refill() {
+    size_t count = 0;
+    void *head = _pool._get_magazine(count);
+    if (head == nullptr) {
+        head = _pool._carve_slab(count);
+    }
+    if (head == nullptr) {
+        return false;
+    }
+
+    _loaded = head;
+    _loaded_count = count;
+    return true;
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,60 @@
+#include <afina/allocator/PoolSet.h>
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+// Size of the smallest class
+const size_t kMinClass = 64;
+
+// Index of the smallest class holding objects of the given size
+size_t class_of(size_t size) {
+    size_t cls = 0;
+    for (size_t object = kMinClass; object < size; object <<= 1) {
+        cls++;
+    }
+    return cls;
+}
+
+} // namespace
+
+// See PoolSet.h
+PoolSet::PoolSet(void *base, size_t size, size_t max_object, size_t slab_size)
+    : _max_object(max_object), _slabs(base, size, slab_size) {
+    if (max_object < kMinClass || max_object > slab_size / 2) {
+        throw std::runtime_error("Largest class must fit into half of slab");
+    }
+
+    for (size_t object = kMinClass; object <= max_object; object <<= 1) {
+        _pools.emplace_back(new Mempool(_slabs, object));
+    }
+    _max_object = kMinClass << (_pools.size() - 1);
+}
+
+// See PoolSet.h
+void *PoolSet::alloc(size_t size) {
+    if (size > _max_object) {
+        return nullptr;
+    }
+    return _cache(class_of(size)).alloc();
+}
+
+// See PoolSet.h
+void PoolSet::free(void *ptr, size_t size) { _cache(class_of(size)).free(ptr); }
+
+// See PoolSet.h
+Mempool::ThreadCache &PoolSet::_cache(size_t cls) {
+    thread_caches &caches = _caches.get();
+    if (caches.items.empty()) {
+        for (auto &pool : _pools) {
+            caches.items.emplace_back(new Mempool::ThreadCache(*pool));
+        }
+    }
+    return *caches.items[cls];
+}
+
+} // namespace Allocator
+} // namespace Afina
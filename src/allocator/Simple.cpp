@@ -1,40 +1,621 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
-
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
-
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
-
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
-
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+namespace {
+
+// All blocks are aligned on that boundary
+const size_t kAlign = 8;
+
+// Smallest chunk, free chunk must be able to hold free list link
+const size_t kMinChunk = 16;
+
+// Each next class is that much larger than previous one
+const double kGrowFactor = 1.25;
+
+// Bounds for the slab size
+const size_t kMinSlab = 256;
+const size_t kMaxAutoSlab = 1 << 20;
+const size_t kMaxSlab = 1 << 30;
+
+// Automatically selected slab size keeps at least that many slabs in the area
+const size_t kMinSlabsCount = 128;
+
+inline size_t align_up(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+
+inline char *align_ptr(void *base) {
+    uintptr_t v = reinterpret_cast<uintptr_t>(base);
+    return reinterpret_cast<char *>(align_up(v, kAlign));
+}
+
+inline size_t auto_slab_size(size_t size) {
+    size_t slab_size = kMinSlab;
+    while (slab_size < kMaxAutoSlab && slab_size * 2 * kMinSlabsCount <= size) {
+        slab_size *= 2;
+    }
+    return slab_size;
+}
+
+} // namespace
+
+// See Simple.h
+Simple::Simple(void *base, size_t size) : Simple(base, size, auto_slab_size(size)) {}
+
+// See Simple.h
+Simple::Simple(void *base, size_t size, size_t slab_size) : _base(align_ptr(base)), _base_len(size) {
+    if (slab_size < kMinSlab || slab_size > kMaxSlab || (slab_size & (slab_size - 1)) != 0) {
+        throw std::invalid_argument("Slab size must be power of 2 between 256 bytes and 1Gb");
+    }
+    _slab_size = slab_size;
+
+    size_t skipped = _base - static_cast<char *>(base);
+    size_t n_slabs = size > skipped ? (size - skipped) / _slab_size : 0;
+    _slabs.assign(n_slabs, slab{kFreeSlab, 0, 0, nullptr, kNoSlab, kNoSlab});
+    _free_slabs = n_slabs;
+
+    // Geometric series of chunk sizes, the last class is exactly half of slab
+    for (size_t sz = kMinChunk; sz <= _slab_size / 2;) {
+        slab_class c;
+        std::memset(&c, 0, sizeof(c));
+        c.chunk_size = sz;
+        c.per_slab = uint32_t(_slab_size / sz);
+        c.partial = kNoSlab;
+        c.stats.chunk_size = sz;
+        _classes.push_back(c);
+
+        size_t next = align_up(size_t(sz * kGrowFactor), kAlign);
+        if (next == sz) {
+            next += kAlign;
+        }
+        if (sz < _slab_size / 2 && next > _slab_size / 2) {
+            next = _slab_size / 2;
+        }
+        sz = next;
+    }
+
+    std::memset(&_large_stats, 0, sizeof(_large_stats));
+    _defrag_cursor = 0;
+    _moves = 0;
+    _pinned = nullptr;
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    void *result = _alloc_block(N);
+    if (result == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No memory for block of " + std::to_string(N) + " bytes");
+    }
+
+    void **slot = _new_handle(result);
+    _owner(_slab_of(result), result) = slot;
+    return Pointer(slot);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._slot == nullptr) {
+        p = alloc(N);
+        return;
+    }
+
+    int32_t idx = _slab_of(p);
+    void *ptr = *p._slot;
+    slab &s = _slabs[idx];
+    size_t cur_size = _block_size(idx);
+    size_t n_slabs = (N + _slab_size - 1) / _slab_size;
+    if (N <= cur_size) {
+        // Shrink in place. Multi slab block gives its tail back to the pool
+        if (s.cls == kLargeSlab && n_slabs > 0 && n_slabs < s.used) {
+            for (uint32_t i = n_slabs; i < s.used; i++) {
+                _slabs[idx + i].cls = kFreeSlab;
+            }
+            _free_slabs += s.used - n_slabs;
+            _large_stats.slabs -= s.used - n_slabs;
+            s.used = uint32_t(n_slabs);
+        }
+        return;
+    }
+
+    int32_t new_cls = _class_for(N);
+    if (s.cls == kLargeSlab || (s.used == 1 && ptr == _slab_start(idx))) {
+        // Block starts at the slab and nothing else lives there, so it could grow in place
+        // if there is enough free slabs right after it
+        uint32_t have = (s.cls == kLargeSlab) ? s.used : 1;
+        bool fits = (new_cls >= 0);
+        if (!fits && idx + n_slabs <= _slabs.size()) {
+            fits = true;
+            for (uint32_t i = have; i < n_slabs && fits; i++) {
+                fits = (_slabs[idx + i].cls == kFreeSlab);
+            }
+        }
+
+        if (fits) {
+            // Drop the block from its current owner accounting...
+            if (s.cls >= 0) {
+                slab_class &c = _classes[s.cls];
+                if (s.used < c.per_slab) {
+                    _partial_remove(idx);
+                }
+                c.stats.slabs--;
+                c.stats.used_chunks--;
+            } else {
+                _large_stats.slabs -= have;
+                _large_stats.used_chunks--;
+            }
+
+            // ...and reassign slabs to the new one
+            if (new_cls >= 0) {
+                _free_slabs++;
+                s.cls = kFreeSlab;
+                _assign_slab(idx, new_cls);
+                s.carved = 1;
+                s.used = 1;
+                slab_class &c = _classes[new_cls];
+                c.stats.used_chunks++;
+                if (c.per_slab == 1) {
+                    _partial_remove(idx);
+                }
+            } else {
+                for (uint32_t i = have; i < n_slabs; i++) {
+                    _slabs[idx + i].cls = kLargeTailSlab;
+                }
+                _free_slabs -= n_slabs - have;
+                s.cls = kLargeSlab;
+                s.used = uint32_t(n_slabs);
+                s.carved = 0;
+                s.free_list = nullptr;
+                s.owners.assign(1, nullptr);
+                _large_stats.slabs += n_slabs;
+                _large_stats.used_chunks++;
+            }
+            _owner(idx, ptr) = p._slot;
+            return;
+        }
+    }
+
+    // Have to move. New block is allocated first so that p remains valid on failure
+    void *fresh = _alloc_block(N);
+    if (fresh == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No memory for block of " + std::to_string(N) + " bytes");
+    }
+    _move(idx, ptr, _slab_of(fresh), fresh);
+    _release(idx, ptr);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._slot == nullptr) {
+        return;
+    }
+
+    int32_t idx = _slab_of(p);
+    _release(idx, *p._slot);
+
+    *p._slot = nullptr;
+    _free_handles.push_back(p._slot);
+    p._slot = nullptr;
+}
+
+// See Simple.h
+void Simple::evict(Pointer &p) {
+    if (p._slot != nullptr) {
+        int32_t cls = _slabs[_slab_of(p)].cls;
+        (cls >= 0 ? _classes[cls].stats : _large_stats).evictions++;
+    }
+    free(p);
+}
+
+// See Simple.h
+void *Simple::alloc_pinned(size_t N) {
+    void *result = _alloc_block(N);
+    if (result == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No memory for block of " + std::to_string(N) + " bytes");
+    }
+
+    int32_t idx = _slab_of(result);
+    _owner(idx, result) = &_pinned;
+    _slabs[idx].pinned++;
+    return result;
+}
+
+// See Simple.h
+void Simple::free_pinned(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    int32_t idx = _slab_of(ptr);
+    if (idx == kNoSlab || _owner(idx, ptr) != &_pinned) {
+        throw AllocError(AllocErrorType::InvalidFree, "Address isn't a pinned block of allocator");
+    }
+    _slabs[idx].pinned--;
+    _release(idx, ptr);
+}
+
+// See Simple.h
+void Simple::defrag() {
+    while (defrag_step(_slab_size)) {
+    }
+}
+
+// See Simple.h
+bool Simple::defrag_step(size_t budget) {
+    size_t moved = 0;
+    for (size_t checked = 0; checked < _classes.size();) {
+        int32_t cls = int32_t(_defrag_cursor);
+        int32_t src = _defrag_source(cls);
+        if (src == kNoSlab) {
+            _defrag_cursor = (_defrag_cursor + 1) % _classes.size();
+            checked++;
+            continue;
+        }
+
+        // Evacuate source slab chunk by chunk into the densest of other partial slabs
+        slab_class &c = _classes[cls];
+        for (uint32_t i = 0; i < _slabs[src].carved && _slabs[src].cls == cls; i++) {
+            if (_slabs[src].owners[i] == nullptr) {
+                continue;
+            }
+            if (moved >= budget) {
+                return true;
+            }
+
+            int32_t dst = kNoSlab;
+            for (int32_t j = c.partial; j != kNoSlab; j = _slabs[j].next) {
+                if (j != src && (dst == kNoSlab || _slabs[j].used > _slabs[dst].used)) {
+                    dst = j;
+                }
+            }
+
+            char *from = _slab_start(src) + size_t(i) * c.chunk_size;
+            void *to = _take_chunk(dst);
+            _move(src, from, dst, to);
+            _release(src, from);
+            moved += c.chunk_size;
+        }
+        checked = 0;
+    }
+    return false;
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    std::stringstream out;
+    out << "slab size " << _slab_size << ", slabs " << _slabs.size() << ", free " << _free_slabs << ", moves "
+        << _moves << std::endl;
+    for (auto &s : stats()) {
+        if (s.slabs == 0 && s.allocs == 0) {
+            continue;
+        }
+
+        if (s.chunk_size == 0) {
+            out << "large";
+        } else {
+            out << "class " << s.chunk_size;
+        }
+        out << ": slabs " << s.slabs << ", used " << s.used_chunks << ", free " << s.free_chunks << ", allocs "
+            << s.allocs << ", failures " << s.failures << ", evictions " << s.evictions << std::endl;
+    }
+    return out.str();
+}
+
+// See Simple.h
+std::vector<SlabClassStats> Simple::stats() const {
+    std::vector<SlabClassStats> result;
+    result.reserve(_classes.size() + 1);
+    for (auto &c : _classes) {
+        result.push_back(c.stats);
+        result.back().free_chunks = c.stats.slabs * c.per_slab - c.stats.used_chunks;
+    }
+    result.push_back(_large_stats);
+    return result;
+}
+
+// See Simple.h
+size_t Simple::class_of(size_t N) const {
+    int32_t cls = _class_for(N);
+    return cls < 0 ? _classes.size() : size_t(cls);
+}
+
+// See Simple.h
+size_t Simple::class_of(const Pointer &p) const {
+    int32_t cls = _slabs[_slab_of(p)].cls;
+    return cls < 0 ? _classes.size() : size_t(cls);
+}
+
+// See Simple.h
+int32_t Simple::_class_for(size_t N) const {
+    if (N > _slab_size / 2) {
+        return -1;
+    }
+
+    // Binary search for the first class large enough
+    int32_t lo = 0, hi = int32_t(_classes.size()) - 1;
+    while (lo < hi) {
+        int32_t mid = (lo + hi) / 2;
+        if (_classes[mid].chunk_size < N) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// See Simple.h
+int32_t Simple::_slab_of(void *ptr) const {
+    char *p = static_cast<char *>(ptr);
+    if (p < _base || p >= _base + _slabs.size() * _slab_size) {
+        return kNoSlab;
+    }
+
+    size_t offset = p - _base;
+    int32_t idx = int32_t(offset / _slab_size);
+    const slab &s = _slabs[idx];
+    if (s.cls >= 0) {
+        size_t in_slab = offset % _slab_size;
+        size_t chunk = _classes[s.cls].chunk_size;
+        if (in_slab % chunk == 0 && in_slab / chunk < s.carved) {
+            return idx;
+        }
+    } else if (s.cls == kLargeSlab && p == _slab_start(idx)) {
+        return idx;
+    }
+    return kNoSlab;
+}
+
+// See Simple.h
+int32_t Simple::_slab_of(const Pointer &p) const {
+    void *ptr = *p._slot;
+    int32_t idx = (ptr == nullptr) ? kNoSlab : _slab_of(ptr);
+    if (idx == kNoSlab || const_cast<Simple *>(this)->_owner(idx, ptr) != p._slot) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't reference live block of allocator");
+    }
+    return idx;
+}
+
+// See Simple.h
+void **&Simple::_owner(int32_t idx, void *ptr) {
+    slab &s = _slabs[idx];
+    if (s.cls < 0) {
+        return s.owners[0];
+    }
+    return s.owners[(static_cast<char *>(ptr) - _slab_start(idx)) / _classes[s.cls].chunk_size];
+}
+
+// See Simple.h
+size_t Simple::_block_size(int32_t idx) const {
+    const slab &s = _slabs[idx];
+    if (s.cls >= 0) {
+        return _classes[s.cls].chunk_size;
+    }
+    return s.used * _slab_size;
+}
+
+// See Simple.h
+int32_t Simple::_find_free_run(uint32_t n) const {
+    if (n > _free_slabs) {
+        return kNoSlab;
+    }
+
+    uint32_t run = 0;
+    for (size_t i = 0; i < _slabs.size(); i++) {
+        run = (_slabs[i].cls == kFreeSlab) ? run + 1 : 0;
+        if (run == n) {
+            return int32_t(i + 1 - n);
+        }
+    }
+    return kNoSlab;
+}
+
+// See Simple.h
+void *Simple::_alloc_block(size_t N) {
+    int32_t cls = _class_for(N);
+    void *result = (cls >= 0) ? _alloc_chunk(cls) : _alloc_large(N);
+    if (result == nullptr) {
+        (cls >= 0 ? _classes[cls].stats : _large_stats).failures++;
+    }
+    return result;
+}
+
+// See Simple.h
+void *Simple::_alloc_chunk(int32_t cls) {
+    slab_class &c = _classes[cls];
+    int32_t idx = c.partial;
+    if (idx == kNoSlab) {
+        idx = _find_free_run(1);
+        if (idx == kNoSlab) {
+            return nullptr;
+        }
+        _assign_slab(idx, cls);
+    }
+
+    c.stats.allocs++;
+    return _take_chunk(idx);
+}
+
+// See Simple.h
+void *Simple::_take_chunk(int32_t idx) {
+    slab &s = _slabs[idx];
+    slab_class &c = _classes[s.cls];
+
+    char *chunk;
+    if (s.free_list != nullptr) {
+        chunk = s.free_list;
+        std::memcpy(&s.free_list, chunk, sizeof(char *));
+    } else {
+        chunk = _slab_start(idx) + size_t(s.carved) * c.chunk_size;
+        s.carved++;
+    }
+
+    s.used++;
+    if (s.used == c.per_slab) {
+        _partial_remove(idx);
+    }
+
+    c.stats.used_chunks++;
+    return chunk;
+}
+
+// See Simple.h
+void *Simple::_alloc_large(size_t N) {
+    uint32_t n = uint32_t((N + _slab_size - 1) / _slab_size);
+    int32_t idx = _find_free_run(n);
+    if (idx == kNoSlab) {
+        return nullptr;
+    }
+
+    slab &s = _slabs[idx];
+    s.cls = kLargeSlab;
+    s.used = n;
+    s.owners.assign(1, nullptr);
+    for (uint32_t i = 1; i < n; i++) {
+        _slabs[idx + i].cls = kLargeTailSlab;
+    }
+    _free_slabs -= n;
+
+    _large_stats.slabs += n;
+    _large_stats.used_chunks++;
+    _large_stats.allocs++;
+    return _slab_start(idx);
+}
+
+// See Simple.h
+void Simple::_release(int32_t idx, void *ptr) {
+    _owner(idx, ptr) = nullptr;
+
+    slab &s = _slabs[idx];
+    if (s.cls == kLargeSlab) {
+        for (uint32_t i = 0; i < s.used; i++) {
+            _slabs[idx + i].cls = kFreeSlab;
+        }
+        _free_slabs += s.used;
+        _large_stats.slabs -= s.used;
+        _large_stats.used_chunks--;
+        s.used = 0;
+        return;
+    }
+
+    slab_class &c = _classes[s.cls];
+    char *chunk = static_cast<char *>(ptr);
+    std::memcpy(chunk, &s.free_list, sizeof(char *));
+    s.free_list = chunk;
+
+    if (s.used == c.per_slab) {
+        _partial_push(idx);
+    }
+    s.used--;
+    c.stats.used_chunks--;
+
+    // Empty slab goes back to the pool, so that any class could reuse it
+    if (s.used == 0) {
+        _partial_remove(idx);
+        s.cls = kFreeSlab;
+        s.carved = 0;
+        s.free_list = nullptr;
+        c.stats.slabs--;
+        _free_slabs++;
+    }
+}
+
+// See Simple.h
+void Simple::_assign_slab(int32_t idx, int32_t cls) {
+    slab &s = _slabs[idx];
+    s.cls = cls;
+    s.used = 0;
+    s.carved = 0;
+    s.free_list = nullptr;
+    s.owners.assign(_classes[cls].per_slab, nullptr);
+    _free_slabs--;
+    _classes[cls].stats.slabs++;
+    _partial_push(idx);
+}
+
+// See Simple.h
+void Simple::_move(int32_t from_idx, void *from, int32_t to_idx, void *to) {
+    void **slot = _owner(from_idx, from);
+    std::memcpy(to, from, std::min(_block_size(from_idx), _block_size(to_idx)));
+    _owner(to_idx, to) = slot;
+    *slot = to;
+    _moves++;
+
+    if (_on_relocate) {
+        _on_relocate(from, to);
+    }
+}
+
+// See Simple.h
+int32_t Simple::_defrag_source(int32_t cls) const {
+    // Evacuation makes sense only if the sparsest slab fits into holes of other ones
+    const slab_class &c = _classes[cls];
+    int32_t src = kNoSlab;
+    size_t holes = 0;
+    for (int32_t j = c.partial; j != kNoSlab; j = _slabs[j].next) {
+        holes += c.per_slab - _slabs[j].used;
+        if (_slabs[j].pinned == 0 && (src == kNoSlab || _slabs[j].used < _slabs[src].used)) {
+            src = j;
+        }
+    }
+
+    if (src == kNoSlab || holes - (c.per_slab - _slabs[src].used) < _slabs[src].used) {
+        return kNoSlab;
+    }
+    return src;
+}
+
+// See Simple.h
+void **Simple::_new_handle(void *ptr) {
+    void **slot;
+    if (_free_handles.empty()) {
+        _handles.push_back(ptr);
+        slot = &_handles.back();
+    } else {
+        slot = _free_handles.back();
+        _free_handles.pop_back();
+        *slot = ptr;
+    }
+    return slot;
+}
+
+// See Simple.h
+void Simple::_partial_push(int32_t idx) {
+    slab &s = _slabs[idx];
+    slab_class &c = _classes[s.cls];
+    s.prev = kNoSlab;
+    s.next = c.partial;
+    if (c.partial != kNoSlab) {
+        _slabs[c.partial].prev = idx;
+    }
+    c.partial = idx;
+}
+
+// See Simple.h
+void Simple::_partial_remove(int32_t idx) {
+    slab &s = _slabs[idx];
+    slab_class &c = _classes[s.cls];
+    if (s.prev != kNoSlab) {
+        _slabs[s.prev].next = s.next;
+    } else if (c.partial == idx) {
+        c.partial = s.next;
+    } else {
+        // Not in the list
+        return;
+    }
+
+    if (s.next != kNoSlab) {
+        _slabs[s.next].prev = s.prev;
+    }
+    s.prev = s.next = kNoSlab;
+}
 
 } // namespace Allocator
 } // namespace Afina
@@ -0,0 +1,80 @@
+#include <afina/allocator/SlabCache.h>
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Allocator {
+
+static_assert(sizeof(std::atomic<void *>) == sizeof(void *), "Block link must fit into the first word of the block");
+
+// See SlabCache.h
+void TaggedStack::push(void *block) {
+    uint32_t ref = _encode(block);
+    uint64_t head = _head.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        _link(block).store(_decode(uint32_t(head)), std::memory_order_relaxed);
+        next = ((head >> 32) + 1) << 32 | ref;
+    } while (!_head.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// See SlabCache.h
+void *TaggedStack::pop() {
+    uint64_t head = _head.load(std::memory_order_acquire);
+    uint64_t next;
+    void *block;
+    do {
+        block = _decode(uint32_t(head));
+        if (block == nullptr) {
+            return nullptr;
+        }
+
+        // Block could be popped by another thread right now, then link is garbage but tag
+        // has changed already and CAS below fails. Link is written concurrently in this case,
+        // so it is read atomically
+        next = ((head >> 32) + 1) << 32 | _encode(_link(block).load(std::memory_order_relaxed));
+    } while (!_head.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire));
+    return block;
+}
+
+// See SlabCache.h
+SlabCache::SlabCache(void *base, size_t size, size_t slab_size)
+    : _base(static_cast<char *>(base)), _slab_size(slab_size), _total(0), _carved(0), _used(0), _free(base) {
+    if (slab_size == 0 || slab_size % 8 != 0 || reinterpret_cast<uintptr_t>(base) % 8 != 0) {
+        throw std::runtime_error("Slab size and area must be 8 bytes aligned");
+    }
+    if (size / 8 >= UINT32_MAX) {
+        throw std::runtime_error("Area is too large for slab cache");
+    }
+    _total = size / slab_size;
+}
+
+// See SlabCache.h
+void *SlabCache::get() {
+    void *slab = _free.pop();
+    if (slab == nullptr) {
+        size_t idx = _carved.fetch_add(1, std::memory_order_relaxed);
+        if (idx >= _total) {
+            // Some slabs could be returned meanwhile
+            _carved.store(_total, std::memory_order_relaxed);
+            slab = _free.pop();
+            if (slab == nullptr) {
+                return nullptr;
+            }
+        } else {
+            slab = _base + idx * _slab_size;
+        }
+    }
+
+    _used.fetch_add(1, std::memory_order_relaxed);
+    return slab;
+}
+
+// See SlabCache.h
+void SlabCache::put(void *slab) {
+    _used.fetch_sub(1, std::memory_order_relaxed);
+    _free.push(slab);
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -1,5 +1,317 @@
 #include <afina/concurrency/Executor.h>
 
+#include <stdexcept>
+
+#include <pthread.h>
+#include <sched.h>
+
 namespace Afina {
-namespace Concurrency {}
+namespace Concurrency {
+
+namespace {
+
+// How many times idle thread looks for work before going to sleep
+const int kSpinRounds = 64;
+
+// Pool thread that is running on the current thread, if any
+thread_local Executor *current_executor = nullptr;
+thread_local std::size_t current_worker = 0;
+
+} // namespace
+
+void perform(Executor *executor, std::size_t idx);
+
+// See Executor.h
+Executor::Executor(std::string name, int size) : Executor(name, size, size) {}
+
+// See Executor.h
+Executor::Executor(std::string name, std::size_t min_threads, std::size_t max_threads,
+                   std::chrono::milliseconds idle_timeout, std::size_t max_queue, RejectPolicy policy,
+                   std::chrono::milliseconds block_timeout)
+    : name(name), min_threads(min_threads), max_threads(max_threads), idle_timeout(idle_timeout),
+      max_queue(max_queue), policy(policy), block_timeout(block_timeout), threads_count(0), idle_count(0),
+      sleeping_count(0), injection_size(0), queue_size(0), blocked_count(0), queued_total(0), rejected_total(0),
+      caller_runs_total(0), state(State::kRun) {
+    if (max_threads == 0 || min_threads > max_threads) {
+        throw std::invalid_argument("Executor requires 0 <= min_threads <= max_threads and max_threads > 0");
+    }
+
+    workers.reserve(max_threads);
+    for (std::size_t i = 0; i < max_threads; i++) {
+        workers.emplace_back(new worker());
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (std::size_t i = 0; i < min_threads; i++) {
+        Spawn();
+    }
+}
+
+// See Executor.h
+Executor::~Executor() {
+    Stop(true);
+
+    // Tasks never started are dropped
+    for (auto t : injection) {
+        delete t;
+    }
+}
+
+// See Executor.h
+void Executor::Stop(bool await) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (state.load() == State::kRun) {
+        // Injection lock makes sure that no external submit is in the middle of enqueue
+        std::lock_guard<std::mutex> injection_lock(injection_mutex);
+        state.store(State::kStopping);
+        if (threads_count.load() == 0) {
+            state.store(State::kStopped);
+        }
+        empty_condition.notify_all();
+        space_condition.notify_all();
+    }
+
+    if (!await) {
+        return;
+    }
+
+    stop_condition.wait(lock, [this] { return state.load() == State::kStopped; });
+    for (auto &w : workers) {
+        if (w->thread.joinable()) {
+            w->thread.join();
+        }
+    }
+}
+
+// See Executor.h
+bool Executor::Submit(std::unique_ptr<task> &exec) {
+    bool local = (current_executor == this);
+    if (max_queue > 0 && !Reserve(!local && policy == RejectPolicy::kBlock)) {
+        if (policy == RejectPolicy::kReject || (policy == RejectPolicy::kBlock && !local)) {
+            rejected_total.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        caller_runs_total.fetch_add(1, std::memory_order_relaxed);
+        (*exec)();
+        return true;
+    }
+
+    if (local) {
+        // Own deque of the pool thread, no shared state involved
+        workers[current_worker]->tasks.push(exec.release());
+    } else {
+        std::unique_lock<std::mutex> lock(injection_mutex);
+        if (state.load() != State::kRun) {
+            if (max_queue > 0) {
+                queue_size.fetch_sub(1);
+            }
+            return false;
+        }
+        injection.push_back(exec.release());
+        injection_size.fetch_add(1);
+    }
+
+    queued_total.fetch_add(1, std::memory_order_relaxed);
+    Wake();
+    return true;
+}
+
+// See Executor.h
+bool Executor::Reserve(bool may_block) {
+    auto deadline = std::chrono::steady_clock::now() + block_timeout;
+    for (;;) {
+        if (queue_size.fetch_add(1) < max_queue) {
+            return true;
+        }
+        queue_size.fetch_sub(1);
+
+        if (!may_block || std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+
+        // Thread taking task re-checks blocked_count after it frees space, so either we see
+        // space or it sees us waiting
+        std::unique_lock<std::mutex> lock(mutex);
+        blocked_count.fetch_add(1);
+        if (queue_size.load() >= max_queue && state.load() == State::kRun) {
+            space_condition.wait_until(lock, deadline);
+        }
+        blocked_count.fetch_sub(1);
+        if (state.load() != State::kRun) {
+            return false;
+        }
+    }
+}
+
+// See Executor.h
+Executor::Stats Executor::GetStats() const {
+    Stats result;
+    result.queued = queued_total.load(std::memory_order_relaxed);
+    result.rejected = rejected_total.load(std::memory_order_relaxed);
+    result.caller_runs = caller_runs_total.load(std::memory_order_relaxed);
+    result.in_queue = queue_size.load(std::memory_order_relaxed);
+    return result;
+}
+
+// See Executor.h
+void Executor::Wake() {
+    // Sleeping thread re-checks queues after it is counted as sleeping, so either it sees the task
+    // or we see it sleeping
+    if (sleeping_count.load() > 0 || (idle_count.load() == 0 && threads_count.load() < max_threads)) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (sleeping_count.load() > 0) {
+            empty_condition.notify_one();
+        } else if (idle_count.load() == 0 && threads_count.load() < max_threads && state.load() == State::kRun) {
+            Spawn();
+        }
+    }
+}
+
+// See Executor.h
+Executor::task *Executor::Take(std::size_t idx) {
+    task *result = TakeQueued(idx);
+    if (result != nullptr && max_queue > 0) {
+        queue_size.fetch_sub(1);
+        if (blocked_count.load() > 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            space_condition.notify_one();
+        }
+    }
+    return result;
+}
+
+// See Executor.h
+Executor::task *Executor::TakeQueued(std::size_t idx) {
+    task *result = nullptr;
+    if (workers[idx]->tasks.pop(result)) {
+        return result;
+    }
+
+    if (injection_size.load() > 0) {
+        std::unique_lock<std::mutex> lock(injection_mutex);
+        if (!injection.empty()) {
+            result = injection.front();
+            injection.pop_front();
+            injection_size.fetch_sub(1);
+            return result;
+        }
+    }
+
+    // Start stealing from the next thread so that victims are spread evenly
+    for (std::size_t i = 1; i < workers.size(); i++) {
+        worker &victim = *workers[(idx + i) % workers.size()];
+        if (victim.tasks.steal(result)) {
+            return result;
+        }
+    }
+    return nullptr;
+}
+
+// See Executor.h
+bool Executor::HasTasks() const {
+    if (injection_size.load() > 0) {
+        return true;
+    }
+    for (auto &w : workers) {
+        if (!w->tasks.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// See Executor.h
+void Executor::Spawn() {
+    for (std::size_t i = 0; i < workers.size(); i++) {
+        worker &w = *workers[i];
+        if (w.active) {
+            continue;
+        }
+
+        // Thread previously running in the slot has already left the loop
+        if (w.thread.joinable()) {
+            w.thread.join();
+        }
+
+        w.active = true;
+        threads_count.fetch_add(1);
+        idle_count.fetch_add(1);
+        w.thread = std::thread(perform, this, i);
+        return;
+    }
+}
+
+// See Executor.h
+void perform(Executor *executor, std::size_t idx) {
+    using State = Executor::State;
+    current_executor = executor;
+    current_worker = idx;
+
+    std::string name = executor->name + "-" + std::to_string(idx);
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+    // Thread starts idle, see Spawn
+    bool idle = true;
+    for (;;) {
+        Executor::task *t = executor->Take(idx);
+        for (int i = 0; t == nullptr && i < kSpinRounds; i++) {
+            sched_yield();
+            t = executor->Take(idx);
+        }
+
+        if (t != nullptr) {
+            if (idle) {
+                idle = false;
+
+                // The last thread looking for work is leaving, make sure somebody takes the rest
+                if (executor->idle_count.fetch_sub(1) == 1 && executor->HasTasks()) {
+                    executor->Wake();
+                }
+            }
+
+            try {
+                (*t)();
+            } catch (...) {
+                // Task is responsible for own errors, pool must survive anyway
+            }
+            delete t;
+            continue;
+        }
+
+        if (!idle) {
+            executor->idle_count.fetch_add(1);
+            idle = true;
+        }
+
+        // Nothing to do, go to sleep
+        std::unique_lock<std::mutex> lock(executor->mutex);
+        executor->sleeping_count.fetch_add(1);
+        bool timeout = false;
+        if (!executor->HasTasks() && executor->state.load() == State::kRun) {
+            timeout = executor->empty_condition.wait_for(lock, executor->idle_timeout) == std::cv_status::timeout;
+        }
+
+        bool stop = (executor->state.load() != State::kRun) ||
+                    (timeout && executor->threads_count.load() > executor->min_threads);
+        if (!stop || executor->HasTasks()) {
+            executor->sleeping_count.fetch_sub(1);
+            continue;
+        }
+
+        // Leave the pool
+        executor->sleeping_count.fetch_sub(1);
+        executor->idle_count.fetch_sub(1);
+        executor->workers[idx]->active = false;
+        if (executor->threads_count.fetch_sub(1) == 1 && executor->state.load() != State::kRun) {
+            executor->state.store(State::kStopped);
+            executor->stop_condition.notify_all();
+        }
+        break;
+    }
+
+    current_executor = nullptr;
+}
+
+} // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,66 @@
+#include <afina/concurrency/ThreadLocal.h>
+
+#include <atomic>
+
+namespace Afina {
+namespace Concurrency {
+
+namespace {
+
+std::atomic<std::size_t> next_id(0);
+
+// Values of the current thread indexed by ThreadLocal id
+struct thread_table {
+    struct entry {
+        void *value = nullptr;
+        std::weak_ptr<void> owner;
+        void (*release)(const std::shared_ptr<void> &, void *) = nullptr;
+    };
+
+    // Hands values back to registries that are still alive
+    ~thread_table() {
+        for (auto &e : entries) {
+            if (e.value == nullptr) {
+                continue;
+            }
+            std::shared_ptr<void> owner = e.owner.lock();
+            if (owner) {
+                e.release(owner, e.value);
+            }
+        }
+    }
+
+    std::vector<entry> entries;
+};
+
+thread_local thread_table table;
+
+} // namespace
+
+// See ThreadLocal.h
+ThreadLocalBase::ThreadLocalBase() : _id(next_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+// See ThreadLocal.h
+void *ThreadLocalBase::_lookup(std::size_t id) {
+    if (id < table.entries.size()) {
+        return table.entries[id].value;
+    }
+    return nullptr;
+}
+
+// See ThreadLocal.h
+void ThreadLocalBase::_attach(std::size_t id, std::shared_ptr<registry> owner, void *value) {
+    if (id >= table.entries.size()) {
+        table.entries.resize(id + 1);
+    }
+
+    auto &e = table.entries[id];
+    e.value = value;
+    e.owner = std::static_pointer_cast<void>(owner);
+    e.release = [](const std::shared_ptr<void> &owner, void *value) {
+        static_cast<registry *>(owner.get())->release(value);
+    };
+}
+
+} // namespace Concurrency
+} // namespace Afina
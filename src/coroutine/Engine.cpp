@@ -1,19 +1,411 @@
 #include <afina/coroutine/Engine.h>
 
+#include <algorithm>
+
+#include <alloca.h>
 #include <setjmp.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+// Saves callee-saved registers and control words on the current stack, stores stack pointer into *from
+// and restores everything from stack pointed by to. New stack is prepared by Engine::Prepare to look
+// the same, its "return address" is afina_coroutine_entry that calls r13(r12)
+asm(R"(
+    .pushsection .text
+    .globl afina_coroutine_switch
+    .hidden afina_coroutine_switch
+    .type afina_coroutine_switch, @function
+afina_coroutine_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size afina_coroutine_switch, .-afina_coroutine_switch
+
+    .globl afina_coroutine_entry
+    .hidden afina_coroutine_entry
+    .type afina_coroutine_entry, @function
+afina_coroutine_entry:
+    movq %r12, %rdi
+    andq $-16, %rsp
+    callq *%r13
+    ud2
+    .size afina_coroutine_entry, .-afina_coroutine_entry
+    .popsection
+)");
+
+extern "C" void afina_coroutine_switch(void **from, void *to);
+extern "C" void afina_coroutine_entry();
+#endif // __x86_64__
+
 namespace Afina {
 namespace Coroutine {
 
-void Engine::Store(context &ctx) {}
+namespace {
+
+// Initial value of MXCSR and x87 control word: all exceptions masked, round to nearest
+const uint64_t kInitialControlWords = (uint64_t(0x037F) << 32) | 0x1F80;
+
+} // namespace
+
+// See Engine.h
+Engine::~Engine() {
+    for (context *list : {alive, blocked}) {
+        while (list != nullptr) {
+            context *next = list->next;
+            Free(list);
+            list = next;
+        }
+    }
+    Reap();
+
+    while (_pool != nullptr) {
+        context *next = _pool->next;
+        Free(_pool);
+        _pool = next;
+    }
+}
+
+// See Engine.h
+void Engine::Store(context &ctx) {
+    char StackEndsHere;
+
+    // Stack grows down on all supported platforms, but don't rely on that
+    if (&StackEndsHere < StackBottom) {
+        ctx.Low = &StackEndsHere;
+        ctx.Hight = StackBottom;
+    } else {
+        ctx.Low = StackBottom;
+        ctx.Hight = &StackEndsHere;
+    }
+
+    char *&buffer = std::get<0>(ctx.Stack);
+    uint32_t &capacity = std::get<1>(ctx.Stack);
+    std::size_t size = ctx.Hight - ctx.Low;
+    if (capacity < size) {
+        delete[] buffer;
+        buffer = new char[size];
+        capacity = size;
+    }
+    memcpy(buffer, ctx.Low, size);
+}
+
+// See Engine.h
+void Engine::Restore(context &ctx) {
+    char StackEndsHere;
+
+    // Saved stack is about to be copied over the frames above, so move below them first. Function calling
+    // alloca() is never turned into a tail call, so the next call is guaranteed to get a deeper frame
+    if (ctx.Low <= &StackEndsHere && &StackEndsHere <= ctx.Hight) {
+        volatile char *pad = static_cast<char *>(alloca(&StackEndsHere - ctx.Low + 256));
+        pad[0] = 0;
+        Restore(ctx);
+    }
+
+    memcpy(ctx.Low, std::get<0>(ctx.Stack), ctx.Hight - ctx.Low);
+    longjmp(ctx.Environment, 1);
+}
+
+// See Engine.h
+void Engine::yield() {
+    // Round robin: routine following the current one in the alive list, wrapping around to the head,
+    // so that every yielding routine gets its turn
+    context *next = alive;
+    if (cur_routine != nullptr && !cur_routine->Blocked && cur_routine->next != nullptr) {
+        next = cur_routine->next;
+    }
+    if (next != nullptr && next == cur_routine) {
+        next = next->next;
+    }
+
+    if (next != nullptr) {
+        Enter(next);
+    } else if (cur_routine != nullptr && cur_routine->Blocked) {
+        // Nothing could run, but the current routine can't continue either
+        Enter(idle_ctx);
+    }
+}
+
+// See Engine.h
+void Engine::sched(void *routine_) {
+    context *routine = static_cast<context *>(routine_);
+    if (routine == nullptr) {
+        yield();
+        return;
+    }
+
+    if (routine == cur_routine || routine->Blocked) {
+        return;
+    }
+    Enter(routine);
+}
+
+// See Engine.h
+void Engine::block(void *coro) {
+    context *routine = coro != nullptr ? static_cast<context *>(coro) : cur_routine;
+    if (routine == nullptr || routine->Blocked) {
+        return;
+    }
+
+    // Move from alive to blocked
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    } else {
+        alive = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+
+    routine->prev = nullptr;
+    routine->next = blocked;
+    if (blocked != nullptr) {
+        blocked->prev = routine;
+    }
+    blocked = routine;
+    routine->Blocked = true;
+
+    if (routine == cur_routine) {
+        yield();
+    }
+}
+
+// See Engine.h
+void Engine::unblock(void *coro) {
+    context *routine = static_cast<context *>(coro);
+    if (routine == nullptr || !routine->Blocked) {
+        return;
+    }
+
+    // Move from blocked to alive
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    } else {
+        blocked = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+
+    routine->prev = nullptr;
+    routine->next = alive;
+    if (alive != nullptr) {
+        alive->prev = routine;
+    }
+    alive = routine;
+    routine->Blocked = false;
+}
+
+// See Engine.h
+void Engine::Enter(context *ctx) {
+    if (_mode == StackMode::FixedStack) {
+        context *from = cur_routine != nullptr ? cur_routine : idle_ctx;
+        cur_routine = ctx != idle_ctx ? ctx : nullptr;
+        Switch(*from, *ctx);
+
+        // Got control back, may be from the routine which has just finished
+        Reap();
+        return;
+    }
+
+    // Idle context always resumes from the same point in start(), so it is never saved
+    if (cur_routine != nullptr) {
+        if (setjmp(cur_routine->Environment) > 0) {
+            return;
+        }
+        Store(*cur_routine);
+    }
+
+    cur_routine = ctx != idle_ctx ? ctx : nullptr;
+    Restore(*ctx);
+}
+
+// See Engine.h
+bool Engine::Prepare(context &ctx) {
+    std::size_t page = sysconf(_SC_PAGESIZE);
+    if (ctx.Mapped == nullptr) {
+        // Stack is populated right away, so coroutine doesn't take page faults as it goes deeper. Recycled
+        // stacks keep their pages
+        std::size_t size = (_stack_size + page - 1) / page * page + page;
+        void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_POPULATE, -1, 0);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+
+        // Guard page at the lowest address catches stack overflow
+        if (mprotect(mapped, page, PROT_NONE) != 0) {
+            munmap(mapped, size);
+            return false;
+        }
+        ctx.Mapped = static_cast<char *>(mapped);
+        ctx.MappedSize = size;
+    }
+    std::size_t size = ctx.MappedSize;
+
+#if defined(__x86_64__)
+    // Frame as afina_coroutine_switch leaves it: control words, r15, r14, r13, r12, rbx, rbp, return address
+    uint64_t *sp = reinterpret_cast<uint64_t *>(ctx.Mapped + size);
+    *--sp = 0;
+    *--sp = reinterpret_cast<uint64_t>(&afina_coroutine_entry);
+    *--sp = 0;                                          // rbp
+    *--sp = 0;                                          // rbx
+    *--sp = reinterpret_cast<uint64_t>(this);           // r12, argument of Entry
+    *--sp = reinterpret_cast<uint64_t>(&Engine::Entry); // r13
+    *--sp = 0;                                          // r14
+    *--sp = 0;                                          // r15
+    *--sp = kInitialControlWords;
+    ctx.Sp = sp;
+#else
+    getcontext(&ctx.Ucontext);
+    ctx.Ucontext.uc_stack.ss_sp = ctx.Mapped + page;
+    ctx.Ucontext.uc_stack.ss_size = size - page;
+    ctx.Ucontext.uc_link = nullptr;
+    uintptr_t self = reinterpret_cast<uintptr_t>(this);
+    makecontext(&ctx.Ucontext, reinterpret_cast<void (*)()>(&Engine::UcontextEntry), 2, unsigned(uint64_t(self) >> 32),
+                unsigned(self));
+#endif
+    return true;
+}
+
+// See Engine.h
+void Engine::Switch(context &from, context &to) {
+#if defined(__x86_64__)
+    afina_coroutine_switch(&from.Sp, to.Sp);
+#else
+    swapcontext(&from.Ucontext, &to.Ucontext);
+#endif
+}
+
+// See Engine.h
+void Engine::Reap() {
+    if (_finished != nullptr) {
+        Release(_finished);
+        _finished = nullptr;
+    }
+}
+
+// See Engine.h
+void Engine::Idle() {
+    while (true) {
+        if (alive == nullptr) {
+            _unblocker(*this);
+        }
+        if (alive == nullptr) {
+            break;
+        }
+        Enter(alive);
+    }
+    Reap();
+}
+
+// See Engine.h
+void Engine::Entry(Engine *engine) {
+    // Previous routine may have finished right before this one started
+    engine->Reap();
+
+    context *ctx = engine->cur_routine;
+    ctx->BodyCall(ctx->Body);
+    ctx->BodyDestroy(ctx->Body);
+    ctx->BodyCall = ctx->BodyDestroy = nullptr;
+
+    // Routine is done, unlink it and pass control to any other. Stack is still in use here, so it gets released
+    // by whoever runs next
+    if (ctx->prev != nullptr) {
+        ctx->prev->next = ctx->next;
+    } else {
+        engine->alive = ctx->next;
+    }
+    if (ctx->next != nullptr) {
+        ctx->next->prev = ctx->prev;
+    }
+    ctx->prev = ctx->next = nullptr;
+    engine->_finished = ctx;
+
+    context *next = engine->alive != nullptr ? engine->alive : engine->idle_ctx;
+    engine->cur_routine = next != engine->idle_ctx ? next : nullptr;
+    engine->Switch(*ctx, *next);
+}
+
+// See Engine.h
+Engine::context *Engine::Acquire() {
+    _stats.in_use++;
+    _stats.in_use_max = std::max(_stats.in_use_max, _stats.in_use);
+
+    if (_pool != nullptr) {
+        context *ctx = _pool;
+        _pool = ctx->next;
+        ctx->next = nullptr;
+        _stats.pooled--;
+        _stats.reused++;
+        return ctx;
+    }
+
+    _stats.created++;
+    return new context();
+}
+
+// See Engine.h
+void Engine::Release(context *ctx) {
+    _stats.in_use--;
+    if (_stats.pooled >= _max_pooled) {
+        Free(ctx);
+        return;
+    }
 
-void Engine::Restore(context &ctx) {}
+    // Stack and its copy buffer stay with context
+    if (ctx->BodyDestroy != nullptr) {
+        ctx->BodyDestroy(ctx->Body);
+        ctx->BodyCall = ctx->BodyDestroy = nullptr;
+    }
+    ctx->prev = nullptr;
+    ctx->Blocked = false;
+    ctx->next = _pool;
+    _pool = ctx;
+    _stats.pooled++;
+    _stats.pooled_max = std::max(_stats.pooled_max, _stats.pooled);
+}
 
-void Engine::yield() {}
+// See Engine.h
+void Engine::Free(context *ctx) {
+    if (ctx->BodyDestroy != nullptr) {
+        ctx->BodyDestroy(ctx->Body);
+    }
+    if (ctx->Mapped != nullptr) {
+        munmap(ctx->Mapped, ctx->MappedSize);
+    }
+    delete[] std::get<0>(ctx->Stack);
+    delete ctx;
+}
 
-void Engine::sched(void *routine_) {}
+#if !defined(__x86_64__)
+// See Engine.h
+void Engine::UcontextEntry(unsigned int hi, unsigned int lo) {
+    uintptr_t self = (uint64_t(hi) << 32) | lo;
+    Entry(reinterpret_cast<Engine *>(self));
+}
+#endif
 
 } // namespace Coroutine
 } // namespace Afina
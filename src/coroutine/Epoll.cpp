@@ -0,0 +1,308 @@
+#include <afina/coroutine/Epoll.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Coroutine {
+
+// See Epoll.h
+Epoll::Epoll() : _free_timers(kNotQueued), _waiting(0) {
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+}
+
+// See Epoll.h
+Epoll::~Epoll() { close(_epoll_fd); }
+
+// See Epoll.h
+void Epoll::Poll(Engine &engine) {
+    std::array<struct epoll_event, 64> events;
+    while (_waiting > 0) {
+        // Wake up no later than the nearest deadline, rounding up so that it has passed for sure
+        int timeout = -1;
+        if (!_timers.empty()) {
+            auto left =
+                _timer_pool[_timers[0]].deadline - clock::now() + std::chrono::milliseconds(1) - clock::duration(1);
+            timeout = int(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(left).count()));
+        }
+
+        int n = epoll_wait(_epoll_fd, &events[0], events.size(), timeout);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to wait for events: " + std::string(strerror(errno)));
+        }
+
+        // Errors and hangups wake both sides, their next call gets the error or end of stream
+        bool woken = false;
+        for (int i = 0; i < n; i++) {
+            waiters &w = _fds[events[i].data.fd];
+            uint32_t mask = events[i].events;
+            if (w.reader != nullptr && (mask & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP))) {
+                engine.unblock(w.reader);
+                w.reader = nullptr;
+                woken = true;
+            }
+            if (w.writer != nullptr && (mask & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                engine.unblock(w.writer);
+                w.writer = nullptr;
+                woken = true;
+            }
+        }
+
+        woken = _expire(engine) || woken;
+
+        // Edge triggered events could arrive for descriptors nobody waits for now
+        if (woken) {
+            return;
+        }
+    }
+}
+
+// See Epoll.h
+ssize_t Epoll::co_read(Engine &engine, int fd, void *buf, std::size_t count, clock::time_point deadline) {
+    _watch(fd);
+    for (;;) {
+        ssize_t n = read(fd, buf, count);
+        if (n >= 0) {
+            return n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (!_wait(engine, fd, false, deadline)) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+        } else if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+// See Epoll.h
+ssize_t Epoll::co_write(Engine &engine, int fd, const void *buf, std::size_t count, clock::time_point deadline) {
+    _watch(fd);
+    const char *data = static_cast<const char *>(buf);
+    std::size_t written = 0;
+    while (written < count) {
+        ssize_t n = send(fd, data + written, count - written, MSG_NOSIGNAL);
+        if (n >= 0) {
+            written += n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (!_wait(engine, fd, true, deadline)) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+        } else if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return count;
+}
+
+// See Epoll.h
+int Epoll::co_accept(Engine &engine, int fd, struct sockaddr *addr, socklen_t *addrlen, clock::time_point deadline) {
+    _watch(fd);
+    for (;;) {
+        int client = accept4(fd, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client >= 0) {
+            return client;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (!_wait(engine, fd, false, deadline)) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            return -1;
+        }
+    }
+}
+
+// See Epoll.h
+void Epoll::co_close(int fd) {
+    if (fd >= 0 && std::size_t(fd) < _fds.size()) {
+        _fds[fd] = waiters();
+    }
+    close(fd);
+}
+
+// See Epoll.h
+void Epoll::_watch(int fd) {
+    if (std::size_t(fd) >= _fds.size()) {
+        _fds.resize(fd + 1);
+    }
+
+    waiters &w = _fds[fd];
+    if (!w.registered) {
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = fd;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            throw std::runtime_error("Failed to add file descriptor to epoll: " + std::string(strerror(errno)));
+        }
+        w.registered = true;
+    }
+}
+
+// See Epoll.h
+void Epoll::sleep_until(Engine &engine, clock::time_point deadline) {
+    if (deadline <= clock::now()) {
+        return;
+    }
+
+    std::size_t t = _new_timer(deadline, engine.current(), -1, false);
+    _push(t);
+    _waiting++;
+    engine.block();
+    _waiting--;
+    _free_timer(t);
+}
+
+// See Epoll.h
+bool Epoll::_wait(Engine &engine, int fd, bool write, clock::time_point deadline) {
+    if (deadline <= clock::now()) {
+        return false;
+    }
+
+    // Table could be reallocated while coroutine sleeps, so slot isn't kept across block
+    waiters &w = _fds[fd];
+    (write ? w.writer : w.reader) = engine.current();
+
+    // Operations without deadline don't need timer at all
+    if (deadline == clock::time_point::max()) {
+        _waiting++;
+        engine.block();
+        _waiting--;
+        return true;
+    }
+
+    std::size_t t = _new_timer(deadline, engine.current(), fd, write);
+    _push(t);
+    _waiting++;
+    engine.block();
+    _waiting--;
+
+    // Woken up by descriptor, deadline isn't needed anymore
+    if (_timer_pool[t].index != kNotQueued) {
+        _remove(t);
+    }
+    bool fired = _timer_pool[t].fired;
+    _free_timer(t);
+    return !fired;
+}
+
+// See Epoll.h
+bool Epoll::_expire(Engine &engine) {
+    bool woken = false;
+    auto now = clock::now();
+    while (!_timers.empty() && _timer_pool[_timers[0]].deadline <= now) {
+        std::size_t handle = _timers[0];
+        _remove(handle);
+        timer *t = &_timer_pool[handle];
+
+        // Coroutine could be woken by descriptor in the same round, then it isn't timed out
+        if (t->fd >= 0) {
+            waiters &w = _fds[t->fd];
+            void *&slot = t->write ? w.writer : w.reader;
+            if (slot != t->routine) {
+                continue;
+            }
+            slot = nullptr;
+        }
+
+        t->fired = true;
+        engine.unblock(t->routine);
+        woken = true;
+    }
+    return woken;
+}
+
+// See Epoll.h
+std::size_t Epoll::_new_timer(clock::time_point deadline, void *routine, int fd, bool write) {
+    std::size_t t = _free_timers;
+    if (t == kNotQueued) {
+        t = _timer_pool.size();
+        _timer_pool.emplace_back();
+    } else {
+        _free_timers = _timer_pool[t].index;
+    }
+    _timer_pool[t] = timer{deadline, routine, fd, write, kNotQueued, false};
+    return t;
+}
+
+// See Epoll.h
+void Epoll::_free_timer(std::size_t t) {
+    _timer_pool[t].index = _free_timers;
+    _free_timers = t;
+}
+
+// See Epoll.h
+void Epoll::_push(std::size_t t) {
+    std::size_t i = _timers.size();
+    _timer_pool[t].index = i;
+    _timers.push_back(t);
+    _sift_up(i);
+}
+
+// See Epoll.h
+void Epoll::_remove(std::size_t t) {
+    std::size_t i = _timer_pool[t].index;
+    _timer_pool[t].index = kNotQueued;
+
+    std::size_t last = _timers.back();
+    _timers.pop_back();
+    if (last != t) {
+        _timers[i] = last;
+        _timer_pool[last].index = i;
+        _sift_up(i);
+        _sift_down(_timer_pool[last].index);
+    }
+}
+
+// See Epoll.h
+void Epoll::_sift_up(std::size_t i) {
+    while (i > 0) {
+        std::size_t parent = (i - 1) / 2;
+        if (_timer_pool[_timers[parent]].deadline <= _timer_pool[_timers[i]].deadline) {
+            break;
+        }
+        std::swap(_timers[parent], _timers[i]);
+        _timer_pool[_timers[parent]].index = parent;
+        _timer_pool[_timers[i]].index = i;
+        i = parent;
+    }
+}
+
+// See Epoll.h
+void Epoll::_sift_down(std::size_t i) {
+    for (;;) {
+        std::size_t smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < _timers.size() && _timer_pool[_timers[left]].deadline < _timer_pool[_timers[smallest]].deadline) {
+            smallest = left;
+        }
+        if (right < _timers.size() && _timer_pool[_timers[right]].deadline < _timer_pool[_timers[smallest]].deadline) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        std::swap(_timers[smallest], _timers[i]);
+        _timer_pool[_timers[smallest]].index = smallest;
+        _timer_pool[_timers[i]].index = i;
+        i = smallest;
+    }
+}
+
+} // namespace Coroutine
+} // namespace Afina
@@ -0,0 +1,36 @@
+#include <afina/execute/Counters.h>
+
+namespace Afina {
+namespace Execute {
+
+namespace {
+
+Concurrency::CoreLocal<Counters> &counters() {
+    static Concurrency::CoreLocal<Counters> instance;
+    return instance;
+}
+
+} // namespace
+
+// See Counters.h
+Counters &Counters::local() { return counters().local(); }
+
+// See Counters.h
+void Counters::Collect(std::vector<std::pair<std::string, std::string>> &stats) {
+    uint64_t gets = 0, hits = 0, misses = 0, bytes = 0;
+    auto &all = counters();
+    for (std::size_t i = 0; i < all.size(); i++) {
+        gets += all[i].gets.load(std::memory_order_relaxed);
+        hits += all[i].hits.load(std::memory_order_relaxed);
+        misses += all[i].misses.load(std::memory_order_relaxed);
+        bytes += all[i].bytes.load(std::memory_order_relaxed);
+    }
+
+    stats.emplace_back("cmd_get", std::to_string(gets));
+    stats.emplace_back("get_hits", std::to_string(hits));
+    stats.emplace_back("get_misses", std::to_string(misses));
+    stats.emplace_back("get_bytes", std::to_string(bytes));
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,9 +1,14 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Response.h>
 
+#include <cstdio>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <sstream>
+#include <utility>
 
 namespace Afina {
 namespace Execute {
@@ -26,18 +31,51 @@ void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
     copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
     std::cout << "Get(" << keyStream.str() << ")" << std::endl;
 
-    std::stringstream outStream;
-
     std::string value;
+    uint64_t hits = 0, bytes = 0;
+    out.resize(0);
     for (auto &key : _keys) {
         if (!storage.Get(key, value))
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        hits++;
+        bytes += value.size();
+        out.append("VALUE ").append(key).append(" 0 ").append(std::to_string(value.size())).append("\r\n");
+        out.append(value).append("\r\n");
     }
-    outStream << "END"; // networking layer should add the last \r\n
+    out.append("END"); // networking layer should add the last \r\n
+
+    Count(hits, bytes);
+}
+
+void Get::Execute(Storage &storage, const std::string &args, Response &out) {
+    uint64_t hits = 0, bytes = 0;
+    for (auto &key : _keys) {
+        // Response keeps value alive until it is sent
+        Storage::Value value;
+        if (!storage.Get(key, value))
+            continue;
+        hits++;
+        bytes += value->size();
+
+        char header[32];
+        int len = std::snprintf(header, sizeof(header), " 0 %zu\r\n", value->size());
+        out.Append("VALUE ", 6);
+        out.Append(key);
+        out.Append(header, len);
+        out.Reference(std::move(value));
+        out.Append("\r\n", 2);
+    }
+    out.Append("END\r\n", 5);
+
+    Count(hits, bytes);
+}
 
-    out = outStream.str();
+void Get::Count(uint64_t hits, uint64_t bytes) const {
+    Counters &counters = Counters::local();
+    counters.gets.fetch_add(_keys.size(), std::memory_order_relaxed);
+    counters.hits.fetch_add(hits, std::memory_order_relaxed);
+    counters.misses.fetch_add(_keys.size() - hits, std::memory_order_relaxed);
+    counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
 }
 
 } // namespace Execute
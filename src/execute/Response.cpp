@@ -0,0 +1,125 @@
+#include <afina/execute/Response.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace Afina {
+namespace Execute {
+
+namespace {
+
+// Consumed segments are kept until response drains, unless there are more of them than this
+const std::size_t kCompactSegments = 64;
+
+} // namespace
+
+// See Response.h
+void Response::Append(const char *data, std::size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    // Bytes copied one after another form a single segment
+    if (_segments.size() > _first && _segments.back().data == nullptr) {
+        _segments.back().size += size;
+    } else {
+        _segments.push_back(segment{nullptr, _buffer.size(), size, nullptr});
+    }
+    _buffer.append(data, size);
+    _size += size;
+}
+
+// See Response.h
+void Response::Reference(const char *data, std::size_t size, std::shared_ptr<const void> owner) {
+    if (size == 0) {
+        return;
+    }
+    _segments.push_back(segment{data, 0, size, std::move(owner)});
+    _size += size;
+}
+
+// See Response.h
+std::size_t Response::Fill(struct iovec *iov, std::size_t count) const {
+    std::size_t filled = 0;
+    for (std::size_t i = _first; i < _segments.size() && filled < count; i++, filled++) {
+        const segment &s = _segments[i];
+        std::size_t skip = (i == _first) ? _first_sent : 0;
+        iov[filled].iov_base = const_cast<char *>(_start(s)) + skip;
+        iov[filled].iov_len = s.size - skip;
+    }
+    return filled;
+}
+
+// See Response.h
+void Response::Consume(std::size_t bytes) {
+    bytes = std::min(bytes, _size);
+    while (bytes > 0) {
+        segment &s = _segments[_first];
+        std::size_t left = s.size - _first_sent;
+        if (bytes < left) {
+            _first_sent += bytes;
+            _size -= bytes;
+            break;
+        }
+
+        // Segment is sent completely, value it references could go away
+        bytes -= left;
+        _size -= left;
+        s.owner.reset();
+        _first++;
+        _first_sent = 0;
+    }
+
+    if (_size == 0) {
+        Clear();
+    } else {
+        _compact();
+    }
+}
+
+// See Response.h
+void Response::Clear() {
+    _buffer.resize(0);
+    _segments.clear();
+    _size = 0;
+    _first = 0;
+    _first_sent = 0;
+}
+
+// See Response.h
+void Response::CopyTo(std::string &out) const {
+    out.reserve(out.size() + _size);
+    for (std::size_t i = _first; i < _segments.size(); i++) {
+        const segment &s = _segments[i];
+        std::size_t skip = (i == _first) ? _first_sent : 0;
+        out.append(_start(s) + skip, s.size - skip);
+    }
+}
+
+// See Response.h
+void Response::_compact() {
+    if (_first < kCompactSegments || _first * 2 < _segments.size()) {
+        return;
+    }
+
+    // Buffer bytes before the first copied segment still in use are sent already
+    std::size_t drop = _buffer.size();
+    for (std::size_t i = _first; i < _segments.size(); i++) {
+        if (_segments[i].data == nullptr) {
+            drop = _segments[i].offset;
+            break;
+        }
+    }
+
+    _buffer.erase(0, drop);
+    _segments.erase(_segments.begin(), _segments.begin() + _first);
+    for (auto &s : _segments) {
+        if (s.data == nullptr) {
+            s.offset -= drop;
+        }
+    }
+    _first = 0;
+}
+
+} // namespace Execute
+} // namespace Afina
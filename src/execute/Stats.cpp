@@ -1,4 +1,5 @@
 #include <afina/Storage.h>
+#include <afina/execute/Counters.h>
 #include <afina/execute/Stats.h>
 
 #include <iostream>
@@ -8,7 +9,29 @@
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+/* memcached protocol:
+
+Each statistic sent by the server looks like this:
+
+STAT <name> <value>\r\n
+
+After all the statistics have been transmitted, the server sends the string
+"END\r\n"
+
+*/
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    Counters::Collect(stats);
+    storage.GetStats(stats);
+
+    std::stringstream outStream;
+    for (auto &stat : stats) {
+        outStream << "STAT " << stat.first << " " << stat.second << "\r\n";
+    }
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
 
 } // namespace Execute
 } // namespace Afina
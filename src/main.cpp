@@ -5,12 +5,15 @@
 #include <atomic>
 #include <semaphore.h>
 #include <signal.h>
+#include <sys/socket.h>
 #include <thread>
+#include <unistd.h>
 
 #include <cxxopts.hpp>
 
 #include <afina/Storage.h>
 #include <afina/Version.h>
+#include <afina/allocator/Arena.h>
 #include <afina/logging/Service.h>
 #include <afina/network/Server.h>
 
@@ -18,9 +21,13 @@
 #include "network/mt_blocking/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
+#include "network/mt_coroutine/ServerImpl.h"
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
+#include "network/st_uring/ServerImpl.h"
 
+#include "storage/FlatCombiningLRU.h"
+#include "storage/ShardedLRU.h"
 #include "storage/SimpleLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
 
@@ -51,15 +58,86 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Storage memory could be preallocated with mmap instead of heap
+        std::shared_ptr<Allocator::Arena> arena;
+        if (options.count("memory") > 0) {
+            int memory = options["memory"].as<int>();
+            if (memory <= 0) {
+                throw std::runtime_error("Memory size must be positive");
+            }
+            arena = std::make_shared<Allocator::Arena>(size_t(memory) << 20, options.count("hugepages") > 0);
+        }
+
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = arena ? std::make_shared<Afina::Backend::SimpleLRU>(arena)
+                            : std::make_shared<Afina::Backend::SimpleLRU>();
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = arena ? std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(arena)
+                            : std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+        } else if (storage_type == "fc_lru") {
+            storage = arena ? std::make_shared<Afina::Backend::FlatCombiningLRU>(arena)
+                            : std::make_shared<Afina::Backend::FlatCombiningLRU>();
+        } else if (storage_type == "sharded_lru") {
+            int shards = 16;
+            if (options.count("shards") > 0) {
+                shards = options["shards"].as<int>();
+            }
+            if (shards <= 0) {
+                throw std::runtime_error("Number of shards must be positive");
+            }
+            storage = arena ? std::make_shared<Afina::Backend::ShardedLRU>(shards, arena)
+                            : std::make_shared<Afina::Backend::ShardedLRU>(shards);
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
         // Step 2: Configure network
+        port = 8080;
+        if (options.count("port") > 0) {
+            int value = options["port"].as<int>();
+            if (value <= 0 || value > 65535) {
+                throw std::runtime_error("Port must be in range 1..65535");
+            }
+            port = uint16_t(value);
+        }
+
+        backlog = SOMAXCONN;
+        if (options.count("backlog") > 0) {
+            backlog = options["backlog"].as<int>();
+            if (backlog <= 0) {
+                throw std::runtime_error("Listen backlog must be positive");
+            }
+        }
+
+        acceptors = 2;
+        if (options.count("acceptors") > 0) {
+            int value = options["acceptors"].as<int>();
+            if (value <= 0) {
+                throw std::runtime_error("Number of acceptors must be positive");
+            }
+            acceptors = uint32_t(value);
+        }
+
+        // One worker per core unless said otherwise
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? uint32_t(cpus) : 1;
+        if (options.count("workers") > 0) {
+            int value = options["workers"].as<int>();
+            if (value <= 0) {
+                throw std::runtime_error("Number of workers must be positive");
+            }
+            workers = uint32_t(value);
+        }
+
+        read_timeout = std::chrono::milliseconds(5000);
+        if (options.count("read-timeout") > 0) {
+            int value = options["read-timeout"].as<int>();
+            if (value < 0) {
+                throw std::runtime_error("Read timeout must not be negative");
+            }
+            read_timeout = std::chrono::milliseconds(value);
+        }
+
         std::string network_type = "st_block";
         if (options.count("network") > 0) {
             network_type = options["network"].as<std::string>();
@@ -72,9 +150,25 @@ public:
         } else if (network_type == "st_nonblock") {
             server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
         } else if (network_type == "mt_nonblock") {
-            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+            using ListenMode = Afina::Network::MTnonblock::ServerImpl::ListenMode;
+            ListenMode listen_mode = ListenMode::kShared;
+            if (options.count("listen") > 0) {
+                std::string mode = options["listen"].as<std::string>();
+                if (mode == "reuseport") {
+                    listen_mode = ListenMode::kReusePort;
+                } else if (mode == "reuseport_cpu") {
+                    listen_mode = ListenMode::kReusePortCPU;
+                } else if (mode != "shared") {
+                    throw std::runtime_error("Unknown listen mode");
+                }
+            }
+            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService, listen_mode);
         } else if (network_type == "st_coroutine") {
             server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
+        } else if (network_type == "mt_coroutine") {
+            server = std::make_shared<Afina::Network::MTcoroutine::ServerImpl>(storage, logService);
+        } else if (network_type == "st_uring") {
+            server = std::make_shared<Afina::Network::STuring::ServerImpl>(storage, logService);
         } else {
             throw std::runtime_error("Unknown network type");
         }
@@ -89,10 +183,8 @@ public:
         log->warn("Start storage");
         storage->Start();
 
-        // TODO: configure network service
-        const uint16_t port = 8080;
-        log->warn("Start network on {}", port);
-        server->Start(port, 2, 2);
+        log->warn("Start network on {} with {} acceptors and {} workers", port, acceptors, workers);
+        server->Start(port, acceptors, workers, backlog, read_timeout);
     }
 
     // Stop services in correct order
@@ -112,6 +204,13 @@ private:
 
     std::shared_ptr<Afina::Storage> storage;
     std::shared_ptr<Network::Server> server;
+
+    // Network service parameters
+    uint16_t port;
+    int backlog;
+    uint32_t acceptors;
+    uint32_t workers;
+    std::chrono::milliseconds read_timeout;
 };
 
 // Signal set that to notify application about time to stop
@@ -131,7 +230,18 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("shards", "Number of shards for sharded_lru storage", cxxopts::value<int>());
+        options.add_options()("memory", "Size of preallocated storage memory in Mb", cxxopts::value<int>());
+        options.add_options()("hugepages", "Back storage memory by huge pages if possible");
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("listen",
+                              "How mt_nonblock acceptors listen: shared, reuseport, reuseport_cpu (acceptor per core)",
+                              cxxopts::value<std::string>());
+        options.add_options()("p,port", "TCP port to listen on", cxxopts::value<int>());
+        options.add_options()("backlog", "Size of the listen queue", cxxopts::value<int>());
+        options.add_options()("acceptors", "Number of threads accepting connections", cxxopts::value<int>());
+        options.add_options()("workers", "Number of threads serving connections", cxxopts::value<int>());
+        options.add_options()("read-timeout", "Idle connection timeout in ms, 0 to disable", cxxopts::value<int>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
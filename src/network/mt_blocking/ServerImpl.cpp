@@ -1,6 +1,8 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -13,6 +15,7 @@
 #include <signal.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <spdlog/logger.h>
@@ -27,14 +30,34 @@ namespace Afina {
 namespace Network {
 namespace MTblocking {
 
+namespace {
+
+// Accepted connections waiting for free thread, see Concurrency::Executor
+const std::size_t kMaxPendingConnections = 128;
+
+// Response segments sent by one writev
+#ifdef IOV_MAX
+const std::size_t kMaxIov = IOV_MAX;
+#else
+const std::size_t kMaxIov = 1024;
+#endif
+
+} // namespace
+
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), _workers([this](worker_state &worker) {
+          std::lock_guard<std::mutex> lock(_retired_lock);
+          _retired.add(worker.stats);
+      }) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
 
 // See Server.h
-void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
+void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers, int backlog,
+                       std::chrono::milliseconds read_timeout) {
+    _read_timeout = read_timeout;
     _logger = pLogging->select("network");
     _logger->info("Start mt_blocking network service");
 
@@ -67,11 +90,16 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Socket bind() failed");
     }
 
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed");
     }
 
+    // Keep one thread warm, others are started on demand and leave after being idle for a while.
+    // Connections above the queue limit are turned away at once rather than wait for minutes
+    _executor.reset(new Concurrency::Executor("mt_blocking", 1, std::max(n_workers, 1u), std::chrono::seconds(10),
+                                              kMaxPendingConnections, Concurrency::Executor::RejectPolicy::kReject));
+
     running.store(true);
     _thread = std::thread(&ServerImpl::OnRun, this);
 }
@@ -80,26 +108,33 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 void ServerImpl::Stop() {
     running.store(false);
     shutdown(_server_socket, SHUT_RDWR);
+
+    // Connections stop reading new commands, but responses for the current ones are still sent
+    std::lock_guard<std::mutex> lock(_connections_lock);
+    for (int client_socket : _connections) {
+        shutdown(client_socket, SHUT_RD);
+    }
 }
 
 // See Server.h
 void ServerImpl::Join() {
     assert(_thread.joinable());
     _thread.join();
+    _executor->Stop(true);
     close(_server_socket);
+
+    worker_stats total;
+    {
+        std::lock_guard<std::mutex> lock(_retired_lock);
+        total.add(_retired);
+    }
+    _workers.for_each([&total](worker_state &worker) { total.add(worker.stats); });
+    _logger->info("Served {} connections, {} commands, {} bytes in, {} bytes out", total.connections.load(),
+                  total.commands.load(), total.bytes_in.load(), total.bytes_out.load());
 }
 
 // See Server.h
 void ServerImpl::OnRun() {
-    // Here is connection state
-    // - parser: parse state of the stream
-    // - command_to_execute: last command parsed out of stream
-    // - arg_remains: how many bytes to read from stream to get command argument
-    // - argument_for_command: buffer stores argument
-    std::size_t arg_remains;
-    Protocol::Parser parser;
-    std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
@@ -125,18 +160,33 @@ void ServerImpl::OnRun() {
         }
 
         // Configure read timeout
-        {
+        if (_read_timeout.count() > 0) {
             struct timeval tv;
-            tv.tv_sec = 5; // TODO: make it configurable
-            tv.tv_usec = 0;
+            tv.tv_sec = _read_timeout.count() / 1000;
+            tv.tv_usec = (_read_timeout.count() % 1000) * 1000;
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
 
-        // TODO: Start new thread and process data from/to connection
+        // Stop clears the flag before it walks connections under the same lock, so socket is either seen
+        // by Stop or isn't served at all
         {
-            static const std::string msg = "TODO: start new thread and process memcached protocol instead";
-            if (send(client_socket, msg.data(), msg.size(), 0) <= 0) {
-                _logger->error("Failed to write response to client: {}", strerror(errno));
+            std::lock_guard<std::mutex> lock(_connections_lock);
+            if (!running.load()) {
+                close(client_socket);
+                break;
+            }
+            _connections.insert(client_socket);
+        }
+
+        if (!_executor->Execute(&ServerImpl::OnConnection, this, client_socket)) {
+            _logger->warn("Connection on descriptor {} rejected, {} rejected so far", client_socket,
+                          _executor->GetStats().rejected);
+
+            static const std::string msg = "SERVER_ERROR too many connections\r\n";
+            send(client_socket, msg.data(), msg.size(), 0);
+            {
+                std::lock_guard<std::mutex> lock(_connections_lock);
+                _connections.erase(client_socket);
             }
             close(client_socket);
         }
@@ -146,6 +196,134 @@ void ServerImpl::OnRun() {
     _logger->warn("Network stopped");
 }
 
+// See ServerImpl.h
+void ServerImpl::OnConnection(int client_socket) {
+    // Here is connection state
+    // - parser: parse state of the stream
+    // - command_to_execute: last command parsed out of stream
+    // - arg_remains: how many bytes to read from stream to get command argument
+    // - argument_for_command: buffer stores argument
+    //
+    // Parser and buffers belong to the pool thread, connection starts from their clean state
+    worker_state &worker = _workers.get();
+    worker.stats.connections.fetch_add(1, std::memory_order_relaxed);
+
+    std::size_t arg_remains = 0;
+    Protocol::Parser &parser = worker.parser;
+    std::string &argument_for_command = worker.argument_for_command;
+    std::unique_ptr<Execute::Command> command_to_execute;
+    parser.Reset();
+    argument_for_command.resize(0);
+
+    // Process connection:
+    // - read commands until socket alive
+    // - execute each command
+    // - send response
+    try {
+        int readed_bytes = -1;
+        char client_buffer[4096];
+        while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
+            _logger->debug("Got {} bytes from socket", readed_bytes);
+            worker.stats.bytes_in.fetch_add(readed_bytes, std::memory_order_relaxed);
+
+            // Single block of data readed from the socket could trigger inside actions a multiple times,
+            // for example:
+            // - read#0: [<command1 start>]
+            // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+            while (readed_bytes > 0) {
+                _logger->debug("Process {} bytes", readed_bytes);
+                // There is no command yet
+                if (!command_to_execute) {
+                    std::size_t parsed = 0;
+                    if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                        // There is no command to be launched, continue to parse input stream
+                        // Here we are, current chunk finished some command, process it
+                        _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                        command_to_execute = parser.Build(arg_remains);
+                        if (arg_remains > 0) {
+                            arg_remains += 2;
+                        }
+                    }
+
+                    // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+                    // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+                    if (parsed == 0) {
+                        break;
+                    } else {
+                        std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
+                        readed_bytes -= parsed;
+                    }
+                }
+
+                // There is command, but we still wait for argument to arrive...
+                if (command_to_execute && arg_remains > 0) {
+                    _logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
+                    // There is some parsed command, and now we are reading argument
+                    std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
+                    argument_for_command.append(client_buffer, to_read);
+
+                    std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
+                    arg_remains -= to_read;
+                    readed_bytes -= to_read;
+                }
+
+                // Thre is command & argument - RUN!
+                if (command_to_execute && arg_remains == 0) {
+                    _logger->debug("Start command execution");
+
+                    Execute::Response &result = worker.result;
+                    result.Clear();
+                    if (argument_for_command.size()) {
+                        argument_for_command.resize(argument_for_command.size() - 2);
+                    }
+                    command_to_execute->Execute(*pStorage, argument_for_command, result);
+
+                    // Send response, values go to socket right from where command left them
+                    std::size_t result_size = result.Size();
+                    struct iovec iov[kMaxIov];
+                    while (!result.Empty()) {
+                        ssize_t n = writev(client_socket, iov, result.Fill(iov, kMaxIov));
+                        if (n <= 0) {
+                            throw std::runtime_error("Failed to send response");
+                        }
+                        result.Consume(n);
+                    }
+                    worker.stats.commands.fetch_add(1, std::memory_order_relaxed);
+                    worker.stats.bytes_out.fetch_add(result_size, std::memory_order_relaxed);
+
+                    // Prepare for the next command
+                    command_to_execute.reset();
+                    argument_for_command.resize(0);
+                    parser.Reset();
+                }
+            } // while (readed_bytes)
+        }
+
+        if (readed_bytes == 0) {
+            _logger->debug("Connection closed");
+        } else {
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    }
+
+    // We are done with this connection
+    {
+        std::lock_guard<std::mutex> lock(_connections_lock);
+        _connections.erase(client_socket);
+    }
+    close(client_socket);
+}
+
+// See ServerImpl.h
+void ServerImpl::worker_stats::add(const worker_stats &other) {
+    connections.fetch_add(other.connections.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    commands.fetch_add(other.commands.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    bytes_in.fetch_add(other.bytes_in.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    bytes_out.fetch_add(other.bytes_out.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
 } // namespace MTblocking
 } // namespace Network
 } // namespace Afina
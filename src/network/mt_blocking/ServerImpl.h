@@ -2,10 +2,21 @@
 #define AFINA_NETWORK_MT_BLOCKING_SERVER_H
 
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
 #include <thread>
 
+#include <afina/concurrency/Executor.h>
+#include <afina/concurrency/ThreadLocal.h>
+#include <afina/execute/Response.h>
+
 #include <afina/network/Server.h>
 
+#include "protocol/Parser.h"
+
 namespace spdlog {
 class logger;
 }
@@ -16,7 +27,8 @@ namespace MTblocking {
 
 /**
  * # Network resource manager implementation
- * Server that is spawning a separate thread for each connection
+ * Server that is serving each connection by a separate thread of the pool. Pool grows up to
+ * the number of workers, connections above that wait in the pool queue
  */
 class ServerImpl : public Server {
 public:
@@ -24,7 +36,7 @@ public:
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t, uint32_t) override;
+    void Start(uint16_t port, uint32_t, uint32_t, int backlog, std::chrono::milliseconds read_timeout) override;
 
     // See Server.h
     void Stop() override;
@@ -38,7 +50,32 @@ protected:
      */
     void OnRun();
 
+    /**
+     * Method is running on the pool thread, serves the given connection until client closes it
+     * or server stops
+     */
+    void OnConnection(int client_socket);
+
 private:
+    // Counters of connections served, read by Join once workers are gone
+    struct worker_stats {
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> commands{0};
+        std::atomic<uint64_t> bytes_in{0};
+        std::atomic<uint64_t> bytes_out{0};
+
+        void add(const worker_stats &other);
+    };
+
+    // State of the pool thread reused by all connections it serves one after another, so buffers
+    // keep their capacity and request processing doesn't allocate once they are warm
+    struct worker_state {
+        Protocol::Parser parser;
+        std::string argument_for_command;
+        Execute::Response result;
+        worker_stats stats;
+    };
+
     // Logger instance
     std::shared_ptr<spdlog::logger> _logger;
 
@@ -50,8 +87,23 @@ private:
     // Server socket to accept connections on
     int _server_socket;
 
+    // Connection waiting for data longer is closed, zero if there is no timeout. Read-only
+    std::chrono::milliseconds _read_timeout;
+
     // Thread to run network on
     std::thread _thread;
+
+    // Threads serving connections
+    std::unique_ptr<Afina::Concurrency::Executor> _executor;
+
+    // Sockets of connections currently served, so that Stop could interrupt reading from them
+    std::mutex _connections_lock;
+    std::set<int> _connections;
+
+    // Per thread buffers and counters, counters of exited threads are folded into _retired
+    std::mutex _retired_lock;
+    worker_stats _retired;
+    Afina::Concurrency::ThreadLocal<worker_state> _workers;
 };
 
 } // namespace MTblocking
@@ -0,0 +1,70 @@
+#include "ServerImpl.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/logging/Service.h>
+
+#include "Worker.h"
+
+namespace Afina {
+namespace Network {
+namespace MTcoroutine {
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers, int backlog,
+                       std::chrono::milliseconds read_timeout) {
+    _logger = pLogging->select("network");
+
+    // Each worker accepts on its own, so there are no separate acceptors
+    if (n_workers == 0) {
+        n_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    _logger->info("Start mt_coroutine network service with {} workers", n_workers);
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    _workers.reserve(n_workers);
+    for (uint32_t i = 0; i < n_workers; i++) {
+        _workers.emplace_back(new Worker(pStorage, pLogging, i));
+        _workers.back()->Start(port, backlog, read_timeout);
+    }
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    _logger->warn("Stop network service");
+    for (auto &w : _workers) {
+        w->Stop();
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    for (auto &w : _workers) {
+        w->Join();
+    }
+    _workers.clear();
+}
+
+} // namespace MTcoroutine
+} // namespace Network
+} // namespace Afina
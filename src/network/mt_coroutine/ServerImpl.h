@@ -0,0 +1,53 @@
+#ifndef AFINA_NETWORK_MT_COROUTINE_SERVER_H
+#define AFINA_NETWORK_MT_COROUTINE_SERVER_H
+
+#include <memory>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace MTcoroutine {
+
+// Forward declaration, see Worker.h
+class Worker;
+
+/**
+ * # Network resource manager implementation
+ * Shared nothing coroutine server: each worker thread runs own coroutine engine with own epoll and own
+ * listening socket bound with SO_REUSEPORT, so kernel spreads new connections between workers. Connection
+ * stays on the thread that accepted it, threads never wake up each other
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers, int backlog,
+               std::chrono::milliseconds read_timeout) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+private:
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Threads serving connections, one per core unless configured otherwise
+    std::vector<std::unique_ptr<Worker>> _workers;
+};
+
+} // namespace MTcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_COROUTINE_SERVER_H
@@ -0,0 +1,196 @@
+#include "Worker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/logging/Service.h>
+
+#include "network/st_coroutine/Connection.h"
+
+namespace Afina {
+namespace Network {
+namespace MTcoroutine {
+
+namespace {
+
+// Connection coroutine keeps read buffer and parser on stack, commands execution and logging need some more
+const std::size_t kStackSize = 128 * 1024;
+
+// Pause of acceptor after failed accept
+const std::chrono::milliseconds kAcceptBackoff(100);
+
+} // namespace
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl, int id)
+    : _pStorage(ps), _pLogging(pl), _id(id), _server_socket(-1), _event_fd(-1), _running(false) {}
+
+// See Worker.h
+Worker::~Worker() {
+    if (_thread.joinable()) {
+        Stop();
+        Join();
+    }
+}
+
+// See Worker.h
+void Worker::Start(uint16_t port, int backlog, std::chrono::milliseconds read_timeout) {
+    _read_timeout = read_timeout;
+    _logger = _pLogging->select("network");
+
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;         // IPv4
+    server_addr.sin_port = htons(port);       // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+    _server_socket = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (_server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    // All workers bind the same port, kernel balances connections between their sockets
+    int opts = 1;
+    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1 ||
+        setsockopt(_server_socket, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    if (listen(_server_socket, backlog) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _running = true;
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Stop() {
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup worker");
+    }
+}
+
+// See Worker.h
+void Worker::Join() {
+    _thread.join();
+    close(_server_socket);
+    close(_event_fd);
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    // Keep thread on one core, so its connections, stacks and epoll stay in one cache. Not critical if
+    // fails, for example because of restricted cpuset
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(_id % cores, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+        _logger->debug("Worker {} isn't pinned to core", _id);
+    }
+
+    // Epoll is waited for only when all coroutines are blocked on sockets
+    Coroutine::Epoll io;
+    Coroutine::Engine engine([&io](Coroutine::Engine &pe) { io.Poll(pe); },
+                             Coroutine::Engine::StackMode::FixedStack, kStackSize);
+    engine.start(&Worker::OnAccept, this, engine, io);
+
+    auto stats = engine.GetStats();
+    _logger->debug("Worker {} stopped, {} coroutines at most, {} stacks created", _id, stats.in_use_max,
+                   stats.created);
+}
+
+// See Worker.h
+void Worker::OnAccept(Worker *self, Coroutine::Engine &engine, Coroutine::Epoll &io) {
+    engine.run(&Worker::OnStop, std::move(self), engine, io);
+
+    while (self->_running) {
+        struct sockaddr in_addr;
+        socklen_t in_len = sizeof(in_addr);
+        int client_socket = io.co_accept(engine, self->_server_socket, &in_addr, &in_len);
+        if (client_socket == -1) {
+            if (self->_running) {
+                // Error like EMFILE could go away once some connection is closed, let them run meanwhile.
+                // Acceptor might be the only runnable coroutine, so it sleeps rather than yields
+                self->_logger->error("Failed to accept socket: {}", strerror(errno));
+                io.sleep_for(engine, kAcceptBackoff);
+            }
+            continue;
+        }
+
+        // Print host and service info.
+        if (self->_logger->should_log(spdlog::level::debug)) {
+            char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+            if (getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV) ==
+                0) {
+                self->_logger->debug("Worker {} accepted connection on descriptor {} (host={}, port={})", self->_id,
+                                     client_socket, hbuf, sbuf);
+            }
+        }
+
+        self->_connections.insert(client_socket);
+        if (engine.run(&Worker::OnConnection, std::move(self), engine, io, std::move(client_socket)) == nullptr) {
+            self->_logger->error("Failed to start coroutine for descriptor {}", client_socket);
+            self->_connections.erase(client_socket);
+            io.co_close(client_socket);
+        }
+    }
+}
+
+// See Worker.h
+void Worker::OnStop(Worker *self, Coroutine::Engine &engine, Coroutine::Epoll &io) {
+    eventfd_t value;
+    if (io.co_read(engine, self->_event_fd, &value, sizeof(value)) != sizeof(value)) {
+        self->_logger->error("Failed to read stop signal: {}", strerror(errno));
+    }
+
+    // Acceptor wakes up with error, connections stop reading new commands but still send responses for the
+    // current ones
+    self->_running = false;
+    shutdown(self->_server_socket, SHUT_RDWR);
+    for (int client_socket : self->_connections) {
+        shutdown(client_socket, SHUT_RD);
+    }
+}
+
+// See Worker.h
+void Worker::OnConnection(Worker *self, Coroutine::Engine &engine, Coroutine::Epoll &io, int client_socket) {
+    STcoroutine::ServeConnection(engine, io, client_socket, *self->_pStorage, *self->_logger, self->_read_timeout);
+
+    // We are done with this connection
+    self->_connections.erase(client_socket);
+    io.co_close(client_socket);
+}
+
+} // namespace MTcoroutine
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,116 @@
+#ifndef AFINA_NETWORK_MT_COROUTINE_WORKER_H
+#define AFINA_NETWORK_MT_COROUTINE_WORKER_H
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <thread>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Epoll.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+namespace Logging {
+class Service;
+}
+
+namespace Network {
+namespace MTcoroutine {
+
+/**
+ * # Thread running coroutines
+ * Owns listening socket, epoll and coroutine engine. Everything except Stop is accessed by the worker
+ * thread only
+ */
+class Worker {
+public:
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl, int id);
+    ~Worker();
+
+    /**
+     * Opens listening socket on the given port and spawns background thread serving it. Throws if socket
+     * couldn't be opened
+     *
+     * @param read_timeout connection waiting for data or socket space longer is closed, zero disables it
+     */
+    void Start(uint16_t port, int backlog, std::chrono::milliseconds read_timeout);
+
+    /**
+     * Signal background thread to stop. Thread stops accepting new connections and reading new commands,
+     * once responses for the readed ones are sent it exits
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one exits
+     */
+    void Join();
+
+protected:
+    /**
+     * Method executing by background thread
+     */
+    void OnRun();
+
+    /**
+     * Main coroutine: accepts connections and starts coroutine for each
+     */
+    static void OnAccept(Worker *self, Coroutine::Engine &engine, Coroutine::Epoll &io);
+
+    /**
+     * Coroutine waiting for stop signal, interrupts all others once it arrives
+     */
+    static void OnStop(Worker *self, Coroutine::Engine &engine, Coroutine::Epoll &io);
+
+    /**
+     * Coroutine serving the given connection until client closes it or server stops
+     */
+    static void OnConnection(Worker *self, Coroutine::Engine &engine, Coroutine::Epoll &io, int client_socket);
+
+private:
+    Worker(Worker &) = delete;
+    Worker &operator=(Worker &) = delete;
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+
+    // afina services
+    std::shared_ptr<Afina::Logging::Service> _pLogging;
+
+    // Logger to be used
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Index of the worker, also the core thread is pinned to
+    int _id;
+
+    // Socket to accept new connection on, owned by this worker
+    int _server_socket;
+
+    // Event "device" used to signal stop
+    int _event_fd;
+
+    // See Start
+    std::chrono::milliseconds _read_timeout;
+
+    // Worker is accepting connections
+    bool _running;
+
+    // Sockets of connections currently served
+    std::set<int> _connections;
+
+    // Thread serving requests in this worker
+    std::thread _thread;
+};
+
+} // namespace MTcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_COROUTINE_WORKER_H
@@ -1,25 +1,191 @@
 #include "Connection.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
 
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+namespace {
+
+// Client pipelining faster than it reads responses isn't read from until queue drains below this
+// number of bytes
+const std::size_t kMaxOutput = 1024 * 1024;
+
+// Segments sent by one writev
+#ifdef IOV_MAX
+const std::size_t kMaxIov = IOV_MAX;
+#else
+const std::size_t kMaxIov = 1024;
+#endif
+
+} // namespace
+
+// See Connection.h
+Connection::~Connection() { close(_socket); }
+
 // See Connection.h
-void Connection::Start() { std::cout << "Start" << std::endl; }
+void Connection::Start() {
+    _logger->debug("Start connection on descriptor {}", _socket);
+    Rearm();
+}
 
 // See Connection.h
-void Connection::OnError() { std::cout << "OnError" << std::endl; }
+void Connection::OnError() {
+    _logger->debug("Error on descriptor {}", _socket);
+    _alive = false;
+}
 
 // See Connection.h
-void Connection::OnClose() { std::cout << "OnClose" << std::endl; }
+void Connection::OnClose() {
+    _logger->debug("Connection on descriptor {} closed", _socket);
+    _alive = false;
+}
+
+// See Connection.h
+void Connection::DoRead() {
+    ssize_t n = read(_socket, _read_buffer + _read_bytes, sizeof(_read_buffer) - _read_bytes);
+    if (n > 0) {
+        _logger->debug("Got {} bytes from socket {}", n, _socket);
+        _read_bytes += n;
+        try {
+            Process();
+        } catch (std::runtime_error &ex) {
+            _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+            _output.Append(std::string("SERVER_ERROR ") + ex.what() + "\r\n");
+            _eof = true;
+        }
+    } else if (n == 0) {
+        _logger->debug("Client closed descriptor {}", _socket);
+        _eof = true;
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        _logger->error("Failed to read from descriptor {}: {}", _socket, strerror(errno));
+        OnError();
+        return;
+    }
+
+    // Responses are likely to fit into socket buffer, don't wait for another epoll round to send them
+    if (!_output.Empty()) {
+        DoWrite();
+    } else {
+        Rearm();
+    }
+}
 
 // See Connection.h
-void Connection::DoRead() { std::cout << "DoRead" << std::endl; }
+void Connection::DoWrite() {
+    if (!_alive) {
+        return;
+    }
+
+    struct iovec iov[kMaxIov];
+    while (!_output.Empty()) {
+        std::size_t count = _output.Fill(iov, kMaxIov);
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            size += iov[i].iov_len;
+        }
+
+        ssize_t n = writev(_socket, iov, count);
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;
+            }
+            _logger->error("Failed to write to descriptor {}: {}", _socket, strerror(errno));
+            OnError();
+            return;
+        }
+
+        // Socket buffer is full once it took less than offered
+        _output.Consume(n);
+        if (std::size_t(n) < size) {
+            break;
+        }
+    }
+
+    Rearm();
+}
+
+// See Connection.h
+void Connection::Process() {
+    // Single block of data readed from the socket could trigger inside actions a multiple times,
+    // for example:
+    // - read#0: [<command1 start>]
+    // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+    std::size_t pos = 0;
+    while (pos < _read_bytes) {
+        // There is no command yet
+        if (!_command_to_execute) {
+            std::size_t parsed = 0;
+            if (_parser.Parse(_read_buffer + pos, _read_bytes - pos, parsed)) {
+                _logger->debug("Found new command: {} in {} bytes", _parser.Name(), parsed);
+                _command_to_execute = _parser.Build(_arg_remains);
+                if (_arg_remains > 0) {
+                    _arg_remains += 2;
+                }
+            }
+
+            // Parser might fail to consume any bytes, wait for more data then
+            if (parsed == 0) {
+                break;
+            }
+            pos += parsed;
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (_command_to_execute && _arg_remains > 0) {
+            std::size_t to_read = std::min(_arg_remains, _read_bytes - pos);
+            _argument_for_command.append(_read_buffer + pos, to_read);
+            _arg_remains -= to_read;
+            pos += to_read;
+        }
+
+        // There is command & argument - RUN!
+        if (_command_to_execute && _arg_remains == 0) {
+            if (_argument_for_command.size()) {
+                _argument_for_command.resize(_argument_for_command.size() - 2);
+            }
+            _command_to_execute->Execute(*_pStorage, _argument_for_command, _output);
+
+            // Prepare for the next command
+            _command_to_execute.reset();
+            _argument_for_command.resize(0);
+            _parser.Reset();
+        }
+    }
+
+    // Keep the tail for the next read
+    std::memmove(_read_buffer, _read_buffer + pos, _read_bytes - pos);
+    _read_bytes -= pos;
+    if (_read_bytes == sizeof(_read_buffer)) {
+        throw std::runtime_error("Command is too long");
+    }
+}
 
 // See Connection.h
-void Connection::DoWrite() { std::cout << "DoWrite" << std::endl; }
+void Connection::Rearm() {
+    _event.events = 0;
+    if (!_eof && _output.Size() < kMaxOutput) {
+        _event.events |= EPOLLIN;
+    }
+    if (!_output.Empty()) {
+        _event.events |= EPOLLOUT;
+    }
+    if (_event.events == 0) {
+        _alive = false;
+    }
+}
 
 } // namespace MTnonblock
 } // namespace Network
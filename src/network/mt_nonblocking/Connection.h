@@ -2,21 +2,51 @@
 #define AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 
 #include <cstring>
+#include <memory>
+#include <string>
 
 #include <sys/epoll.h>
 
+#include <afina/execute/Command.h>
+#include <afina/execute/Response.h>
+
+#include "protocol/Parser.h"
+
+namespace spdlog {
+class logger;
+}
+
 namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
 namespace Network {
 namespace MTnonblock {
 
+/**
+ * # Client connection
+ * State machine driven by epoll events: reads whatever arrived, parses and executes all complete
+ * commands out of it and queues their responses. Queued responses are sent by one writev, so a batch
+ * of pipelined commands costs one read and one write. Values are referenced by the queue, not copied
+ * into it.
+ *
+ * Connection belongs to the worker it was assigned to. Events it wants are recalculated after each
+ * handler: reading stops once client closed its side or too many responses wait to be sent, connection
+ * dies when there is nothing to read and nothing to send.
+ */
 class Connection {
 public:
-    Connection(int s) : _socket(s) {
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+        : _socket(s), _pStorage(ps), _logger(pl), _alive(true), _eof(false), _read_bytes(0),
+          _arg_remains(0) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
     }
 
-    inline bool isAlive() const { return true; }
+    ~Connection();
+
+    inline bool isAlive() const { return _alive; }
 
     void Start();
 
@@ -30,8 +60,39 @@ private:
     friend class Worker;
     friend class ServerImpl;
 
+    /**
+     * Parses and executes all complete commands in the read buffer, keeps the incomplete tail
+     */
+    void Process();
+
+    /**
+     * Sets events connection waits for according to its state
+     */
+    void Rearm();
+
     int _socket;
     struct epoll_event _event;
+
+    std::shared_ptr<Afina::Storage> _pStorage;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    bool _alive;
+
+    // Client has closed its side, only responses are left to send
+    bool _eof;
+
+    // Received bytes not parsed yet
+    char _read_buffer[4096];
+    std::size_t _read_bytes;
+
+    // Command being received, see st_blocking
+    Protocol::Parser _parser;
+    std::unique_ptr<Execute::Command> _command_to_execute;
+    std::size_t _arg_remains;
+    std::string _argument_for_command;
+
+    // Responses waiting to be sent
+    Execute::Response _output;
 };
 
 } // namespace MTnonblock
@@ -1,5 +1,6 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -7,8 +8,11 @@
 #include <stdexcept>
 
 #include <arpa/inet.h>
+#include <linux/filter.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
@@ -29,14 +33,23 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+namespace {
+
+// Memory mapped for the connections pool, enough for about two thousands connections
+const std::size_t kConnectionsArea = std::size_t(8) << 20;
+
+} // namespace
+
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl, ListenMode mode)
+    : Server(ps, pl), _mode(mode) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
 
 // See Server.h
-void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
+void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers, int backlog,
+                       std::chrono::milliseconds read_timeout) {
     _logger = pLogging->select("network");
     _logger->info("Start mt_nonblocking network service");
 
@@ -47,77 +60,118 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
+    // Steering program sends SYN handled by core c to socket c % n, acceptor of socket i is pinned to
+    // core i. Both agree only if there is acceptor for every core id
+    if (_mode == ListenMode::kReusePortCPU) {
+        long cores = sysconf(_SC_NPROCESSORS_CONF);
+        uint32_t n_cores = cores > 0 ? uint32_t(cores) : 1;
+        if (n_acceptors != n_cores) {
+            _logger->warn("reuseport_cpu needs acceptor per core, starting {} acceptors instead of {}", n_cores,
+                          n_acceptors);
+            n_acceptors = n_cores;
+        }
+    }
+
+    // Create server sockets, order of sockets in the SO_REUSEPORT group is the order of listen
+    if (_mode == ListenMode::kShared) {
+        _server_sockets.push_back(Listen(port, backlog, false));
+    } else {
+        for (uint32_t i = 0; i < n_acceptors; i++) {
+            _server_sockets.push_back(Listen(port, backlog, true));
+        }
+        if (_mode == ListenMode::kReusePortCPU) {
+            SteerByCPU(_server_sockets[0], n_acceptors);
+        }
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Connections pool, those beyond its area are allocated on heap
+    _connections_arena.reset(new Afina::Allocator::Arena(kConnectionsArea, false));
+    _connections_slabs.reset(
+        new Afina::Allocator::SlabCache(_connections_arena->base(), _connections_arena->size()));
+    _connections_pool.reset(new Afina::Allocator::Mempool(*_connections_slabs, sizeof(Connection)));
+
+    // Start IO workers, each one has own epoll
+    _workers.reserve(n_workers);
+    for (int i = 0; i < n_workers; i++) {
+        _workers.emplace_back(pStorage, pLogging, *_connections_pool);
+        _workers.back().Start();
+    }
+
+    // Start acceptors
+    _acceptors.reserve(n_acceptors);
+    for (std::size_t i = 0; i < n_acceptors; i++) {
+        _acceptors.emplace_back(&ServerImpl::OnRun, this, i, _server_sockets[i % _server_sockets.size()]);
+    }
+}
+
+// See ServerImpl.h
+int ServerImpl::Listen(uint16_t port, int backlog, bool reuse_port) {
     struct sockaddr_in server_addr;
     std::memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;         // IPv4
     server_addr.sin_port = htons(port);       // TCP port number
     server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
 
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
+    int server_socket = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (server_socket == -1) {
         throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
     }
 
     int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
+    if (setsockopt(server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1 ||
+        (reuse_port && setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts)) == -1)) {
+        close(server_socket);
         throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
     }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(server_socket);
         throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
     }
 
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
+    make_socket_non_blocking(server_socket);
+    if (listen(server_socket, backlog) == -1) {
+        close(server_socket);
         throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
     }
+    return server_socket;
+}
 
-    // Start IO workers
-    _data_epoll_fd = epoll_create1(0);
-    if (_data_epoll_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
-
-    _event_fd = eventfd(0, EFD_NONBLOCK);
-    if (_event_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
-
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.ptr = nullptr;
-    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
-        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
-    }
-
-    _workers.reserve(n_workers);
-    for (int i = 0; i < n_workers; i++) {
-        _workers.emplace_back(pStorage, pLogging);
-        _workers.back().Start(_data_epoll_fd);
-    }
-
-    // Start acceptors
-    _acceptors.reserve(n_acceptors);
-    for (int i = 0; i < n_acceptors; i++) {
-        _acceptors.emplace_back(&ServerImpl::OnRun, this);
+// See ServerImpl.h
+void ServerImpl::SteerByCPU(int server_socket, uint32_t n_sockets) {
+    // index = cpu % n_sockets. There is socket per core id, see Start, so connection is accepted on the
+    // core that has processed its SYN. Afterwards it is served by the least loaded worker, on any core
+    struct sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, uint32_t(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, n_sockets},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    struct sock_fprog prog;
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+
+    // Group falls back to hash then, still works
+    if (setsockopt(server_socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == -1) {
+        _logger->warn("Failed to attach CPU steering program: {}", strerror(errno));
     }
 }
 
 // See Server.h
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
-    // Said workers to stop
+    // Said workers to stop, each one wakes up by own eventfd
     for (auto &w : _workers) {
         w.Stop();
     }
 
-    // Wakeup threads that are sleep on epoll_wait
+    // Wakeup acceptors that are sleep on epoll_wait
     if (eventfd_write(_event_fd, 1)) {
-        throw std::runtime_error("Failed to wakeup workers");
+        throw std::runtime_error("Failed to wakeup acceptors");
     }
 }
 
@@ -130,11 +184,27 @@ void ServerImpl::Join() {
     for (auto &w : _workers) {
         w.Join();
     }
+
+    for (int server_socket : _server_sockets) {
+        close(server_socket);
+    }
+    _server_sockets.clear();
+    close(_event_fd);
 }
 
 // See ServerImpl.h
-void ServerImpl::OnRun() {
+void ServerImpl::OnRun(std::size_t idx, int server_socket) {
     _logger->info("Start acceptor");
+    if (_mode == ListenMode::kReusePortCPU) {
+        // Core could be offline or out of the process affinity, no SYN is steered to its socket then
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(idx, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            _logger->debug("Acceptor {} isn't pinned to core", idx);
+        }
+    }
+
     int acceptor_epoll = epoll_create1(0);
     if (acceptor_epoll == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
@@ -142,8 +212,8 @@ void ServerImpl::OnRun() {
 
     struct epoll_event event;
     event.events = EPOLLIN | EPOLLEXCLUSIVE;
-    event.data.fd = _server_socket;
-    if (epoll_ctl(acceptor_epoll, EPOLL_CTL_ADD, _server_socket, &event)) {
+    event.data.fd = server_socket;
+    if (epoll_ctl(acceptor_epoll, EPOLL_CTL_ADD, server_socket, &event)) {
         throw std::runtime_error("Failed to add file descriptor to epoll");
     }
 
@@ -174,7 +244,7 @@ void ServerImpl::OnRun() {
 
                 // No need to make these sockets non blocking since accept4() takes care of it.
                 in_len = sizeof in_addr;
-                int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                int infd = accept4(server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
                 if (infd == -1) {
                     if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
                         break; // We have processed all incoming connections.
@@ -192,26 +262,21 @@ void ServerImpl::OnRun() {
                     _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
                 }
 
-                // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd);
-                if (pc == nullptr) {
-                    throw std::runtime_error("Failed to allocate connection");
-                }
-
-                // Register connection in worker's epoll
-                pc->Start();
-                if (pc->isAlive()) {
-                    pc->_event.events |= EPOLLONESHOT;
-                    int epoll_ctl_retval;
-                    if ((epoll_ctl_retval = epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event))) {
-                        _logger->debug("epoll_ctl failed during connection register in workers'epoll: error {}", epoll_ctl_retval);
-                        pc->OnError();
-                        delete pc;
+                // Hand the new FD to the least loaded worker, it registers socket in own epoll
+                Worker *target = &_workers[0];
+                for (auto &w : _workers) {
+                    if (w.Load() < target->Load()) {
+                        target = &w;
                     }
                 }
+                if (!target->Assign(infd)) {
+                    _logger->error("Failed to assign descriptor {}: workers are overloaded", infd);
+                    close(infd);
+                }
             }
         }
     }
+    close(acceptor_epoll);
     _logger->warn("Acceptor stopped");
 }
 
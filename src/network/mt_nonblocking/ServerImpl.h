@@ -1,9 +1,13 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 
+#include <memory>
 #include <thread>
 #include <vector>
 
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/SlabCache.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -23,11 +27,30 @@ class Worker;
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    /**
+     * How acceptors get new connections
+     */
+    enum class ListenMode {
+        // All acceptors wait on one listening socket with EPOLLEXCLUSIVE
+        kShared,
+
+        // Each acceptor has own listening socket bound with SO_REUSEPORT, so each has own accept queue
+        // and kernel spreads connections between them by hash of address
+        kReusePort,
+
+        // Like kReusePort, but there is acceptor per core, pinned to it, and BPF program passes it
+        // connections which SYN was processed on that core. Number of acceptors is set to the number of
+        // cores. Only accept is kept on the core, connection is served by the least loaded worker
+        kReusePortCPU
+    };
+
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               ListenMode mode = ListenMode::kShared);
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers, int backlog,
+               std::chrono::milliseconds read_timeout) override;
 
     // See Server.h
     void Stop() override;
@@ -36,9 +59,22 @@ public:
     void Join() override;
 
 protected:
-    void OnRun();
+    /**
+     * Method executing by acceptor thread, accepts connections on the given socket
+     */
+    void OnRun(std::size_t idx, int server_socket);
     void OnNewConnection();
 
+    /**
+     * Creates listening socket
+     */
+    int Listen(uint16_t port, int backlog, bool reuse_port);
+
+    /**
+     * Attaches program that steers connections to the socket of acceptor running on the core
+     */
+    void SteerByCPU(int server_socket, uint32_t n_sockets);
+
 private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
@@ -48,19 +84,24 @@ private:
     // Read-only
     uint16_t listen_port;
 
-    // Socket to accept new connection on, shared between acceptors
-    int _server_socket;
+    // See ListenMode
+    ListenMode _mode;
+
+    // Sockets to accept new connection on, either one shared between acceptors or one per acceptor
+    std::vector<int> _server_sockets;
 
     // Threads that accepts new connections, each has private epoll instance
     // but share global server socket
     std::vector<std::thread> _acceptors;
 
-    // EPOLL instance shared between workers
-    int _data_epoll_fd;
-
-    // Curstom event "device" used to wakeup workers
+    // Curstom event "device" used to wakeup acceptors
     int _event_fd;
 
+    // Memory connections of all workers are allocated from, must outlive workers
+    std::unique_ptr<Afina::Allocator::Arena> _connections_arena;
+    std::unique_ptr<Afina::Allocator::SlabCache> _connections_slabs;
+    std::unique_ptr<Afina::Allocator::Mempool> _connections_pool;
+
     // threads serving read/write requests
     std::vector<Worker> _workers;
 };
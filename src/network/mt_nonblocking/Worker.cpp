@@ -1,13 +1,20 @@
 #include "Worker.h"
 
+#include <array>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 #include <functional>
-#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
 
 #include <netdb.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <spdlog/logger.h>
 
@@ -20,15 +27,25 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+namespace {
+
+// Sockets accepted faster than worker registers them are rejected above this
+const std::size_t kMaxIncoming = 1024;
+
+} // namespace
+
 // See Worker.h
-Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {
-    // TODO: implementation here
-}
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               Afina::Allocator::Mempool &connections)
+    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1), _event_fd(-1),
+      _incoming(new Afina::Concurrency::BoundedQueue<int>(kMaxIncoming)), _load(0), _pool(&connections) {}
 
 // See Worker.h
 Worker::~Worker() {
-    // TODO: implementation here
+    if (_thread.joinable()) {
+        Stop();
+        Join();
+    }
 }
 
 // See Worker.h
@@ -40,40 +57,93 @@ Worker &Worker::operator=(Worker &&other) {
     _pLogging = std::move(other._pLogging);
     _logger = std::move(other._logger);
     _thread = std::move(other._thread);
+    _incoming = std::move(other._incoming);
+    _connections = std::move(other._connections);
+    _load.store(other._load.load());
+    _pool = other._pool;
+    _cache = std::move(other._cache);
     _epoll_fd = other._epoll_fd;
+    _event_fd = other._event_fd;
 
     other._epoll_fd = -1;
+    other._event_fd = -1;
     return *this;
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start() {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
-        _epoll_fd = epoll_fd;
         _logger = _pLogging->select("network.worker");
+
+        _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (_epoll_fd == -1) {
+            throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+        }
+
+        _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_event_fd == -1) {
+            throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
+            throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+        }
+
         _thread = std::thread(&Worker::OnRun, this);
     }
 }
 
 // See Worker.h
-void Worker::Stop() { isRunning = false; }
+bool Worker::Assign(int socket) {
+    if (!_incoming->push(socket)) {
+        return false;
+    }
+    _load.fetch_add(1, std::memory_order_relaxed);
+
+    if (eventfd_write(_event_fd, 1)) {
+        _logger->error("Failed to wakeup worker: {}", strerror(errno));
+    }
+    return true;
+}
+
+// See Worker.h
+void Worker::Stop() {
+    isRunning = false;
+
+    // Wakeup thread that is sleep on epoll_wait
+    if (_event_fd != -1 && eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup worker");
+    }
+}
 
 // See Worker.h
 void Worker::Join() {
     assert(_thread.joinable());
     _thread.join();
+
+    // Acceptor could assign socket after the thread has exited
+    int socket;
+    while (_incoming->pop(socket)) {
+        close(socket);
+    }
+
+    close(_epoll_fd);
+    close(_event_fd);
+    _epoll_fd = -1;
+    _event_fd = -1;
 }
 
 // See Worker.h
 void Worker::OnRun() {
     assert(_epoll_fd >= 0);
     _logger->trace("OnRun");
+    _cache.reset(new Afina::Allocator::Mempool::ThreadCache(*_pool));
 
     // Process connection events
-    //
-    // Do not forget to use EPOLLEXCLUSIVE flag when register socket
-    // for events to avoid thundering herd type behavior.
     int timeout = -1;
     std::array<struct epoll_event, 64> mod_list;
     while (isRunning) {
@@ -83,15 +153,16 @@ void Worker::OnRun() {
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
 
-            // nullptr is used by server for event_fd "interface", if we got here then server
-            // signals us to wakeup to process some state change, ignore it in INNER loop, react
-            // on changes in OUTHER loop
+            // nullptr is used for event_fd "interface": either new sockets are assigned or worker
+            // is stopping, the latter is checked in OUTHER loop
             if (current_event.data.ptr == nullptr) {
+                OnAssign();
                 continue;
             }
 
             // Some connection gets new data
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
+            uint32_t events = pconn->_event.events;
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
                 _logger->debug("Got EPOLLERR or EPOLLHUP, value of returned events: {}", current_event.events);
                 pconn->OnError();
@@ -110,29 +181,76 @@ void Worker::OnRun() {
                 }
             }
 
-            // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                int epoll_ctl_retval;
-                if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
-                    _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
+            // Change events connection waits for, usually they stay the same
+            if (pconn->isAlive() && pconn->_event.events != events) {
+                if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event)) {
+                    _logger->debug("epoll_ctl failed during connection rearm: {}", strerror(errno));
                     pconn->OnError();
-                    delete pconn;
                 }
             }
+
             // Or delete closed one
-            else {
+            if (!pconn->isAlive()) {
                 if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
+                    _logger->error("Failed to delete connection: {}", strerror(errno));
                 }
-                delete pconn;
+                _connections.erase(pconn);
+                _load.fetch_sub(1, std::memory_order_relaxed);
+                DeleteConnection(pconn);
             }
         }
-        // TODO: Select timeout...
     }
+
+    // Drop connections left, sockets waiting in queue as well
+    OnAssign();
+    for (Connection *pconn : _connections) {
+        DeleteConnection(pconn);
+    }
+    _connections.clear();
+    _cache.reset();
+    _load.store(0, std::memory_order_relaxed);
     _logger->warn("Worker stopped");
 }
 
+// See Worker.h
+void Worker::OnAssign() {
+    eventfd_t value;
+    eventfd_read(_event_fd, &value);
+
+    int socket;
+    while (_incoming->pop(socket)) {
+        Connection *pc = NewConnection(socket);
+        pc->Start();
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+            _logger->error("Failed to register connection: {}", strerror(errno));
+            pc->OnError();
+            _load.fetch_sub(1, std::memory_order_relaxed);
+            DeleteConnection(pc);
+            continue;
+        }
+        _connections.insert(pc);
+    }
+}
+
+// See Worker.h
+Connection *Worker::NewConnection(int socket) {
+    void *mem = _cache->alloc();
+    if (mem == nullptr) {
+        return new Connection(socket, _pStorage, _logger);
+    }
+    return new (mem) Connection(socket, _pStorage, _logger);
+}
+
+// See Worker.h
+void Worker::DeleteConnection(Connection *pconn) {
+    if (!_pool->owns(pconn)) {
+        delete pconn;
+        return;
+    }
+    pconn->~Connection();
+    _cache->free(pconn);
+}
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
@@ -2,8 +2,13 @@
 #define AFINA_NETWORK_MT_NONBLOCKING_WORKER_H
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
 #include <thread>
+#include <unordered_set>
+
+#include <afina/allocator/Mempool.h>
+#include <afina/concurrency/BoundedQueue.h>
 
 namespace spdlog {
 class logger;
@@ -20,25 +25,51 @@ class Service;
 namespace Network {
 namespace MTnonblock {
 
+// Forward declaration, see Connection.h
+class Connection;
+
 /**
  * # Thread running epoll
- * On Start spaws background thread that is doing epoll on the given server
- * socket and process incoming connections and its data
+ * On Start spaws background thread that is doing epoll on its own epoll instance
+ * and process connections assigned to it. Connections never move between workers,
+ * so they are registered once and epoll_ctl is called only when connection changes
+ * events it waits for.
+ *
+ * New sockets are passed by acceptors through lock free queue, worker is woken up by
+ * its eventfd to pick them.
+ *
+ * Connections are allocated from the pool shared by all workers through the worker own
+ * magazines, so accepting and closing connections doesn't contend on a lock.
  */
 class Worker {
 public:
-    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl);
+    /**
+     * @param connections pool connections are allocated from, must outlive the worker
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           Afina::Allocator::Mempool &connections);
     ~Worker();
 
     Worker(Worker &&);
     Worker &operator=(Worker &&);
 
     /**
-     * Spaws new background thread that is doing epoll on the given server
-     * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * Creates epoll instance and spaws new background thread that is doing epoll on it
+     */
+    void Start();
+
+    /**
+     * Passes accepted socket to the worker, it will be registered and being processed
+     * on the worker thread. Could be called from any thread. Returns false if worker
+     * has too many sockets waiting for registration, socket isn't owned by worker then
+     */
+    bool Assign(int socket);
+
+    /**
+     * Number of connections served and waiting for registration, used to choose the least
+     * loaded worker
      */
-    void Start(int epoll_fd);
+    std::size_t Load() const { return _load.load(std::memory_order_relaxed); }
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
@@ -60,6 +91,21 @@ protected:
      */
     void OnRun();
 
+    /**
+     * Registers sockets from the incoming queue
+     */
+    void OnAssign();
+
+    /**
+     * Allocates connection from the worker magazines, from heap if pool is exhausted
+     */
+    Connection *NewConnection(int socket);
+
+    /**
+     * Destroys connection and returns its memory where it has come from
+     */
+    void DeleteConnection(Connection *pconn);
+
 private:
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
@@ -81,6 +127,23 @@ private:
 
     // EPOLL descriptor using for events processing
     int _epoll_fd;
+
+    // Curstom event "device" used to wakeup worker
+    int _event_fd;
+
+    // Sockets accepted for this worker but not registered yet
+    std::unique_ptr<Afina::Concurrency::BoundedQueue<int>> _incoming;
+
+    // Connections served by the worker, accessed from worker thread only
+    std::unordered_set<Connection *> _connections;
+
+    // See Load
+    std::atomic<std::size_t> _load;
+
+    // Pool connections are allocated from and worker thread front end of it, the latter lives
+    // while thread is running
+    Afina::Allocator::Mempool *_pool;
+    std::unique_ptr<Afina::Allocator::Mempool::ThreadCache> _cache;
 };
 
 } // namespace MTnonblock
@@ -34,7 +34,9 @@ ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Loggi
 ServerImpl::~ServerImpl() {}
 
 // See Server.h
-void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
+void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers, int backlog,
+                       std::chrono::milliseconds read_timeout) {
+    _read_timeout = read_timeout;
     _logger = pLogging->select("network");
     _logger->info("Start st_blocking network service");
 
@@ -96,7 +98,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     // connections that we'll allow to queue up. Note that listen() doesn't block until
     // incoming connections arrive. It just makesthe OS aware that this process is willing
     // to accept connections on this socket (which is bound to a specific IP and port)
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed");
     }
@@ -154,10 +156,10 @@ void ServerImpl::OnRun() {
         }
 
         // Configure read timeout
-        {
+        if (_read_timeout.count() > 0) {
             struct timeval tv;
-            tv.tv_sec = 5; // TODO: make it configurable
-            tv.tv_usec = 0;
+            tv.tv_sec = _read_timeout.count() / 1000;
+            tv.tv_usec = (_read_timeout.count() % 1000) * 1000;
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
 
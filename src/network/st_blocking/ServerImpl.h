@@ -24,7 +24,7 @@ public:
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t, uint32_t) override;
+    void Start(uint16_t port, uint32_t, uint32_t, int backlog, std::chrono::milliseconds read_timeout) override;
 
     // See Server.h
     void Stop() override;
@@ -50,6 +50,9 @@ private:
     // Server socket to accept connections on
     int _server_socket;
 
+    // Connection waiting for data longer is closed, zero if there is no timeout. Read-only
+    std::chrono::milliseconds _read_timeout;
+
     // Thread to run network on
     std::thread _thread;
 };
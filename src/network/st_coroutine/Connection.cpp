@@ -1,25 +1,146 @@
 #include "Connection.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+
+#include "protocol/Parser.h"
 
 namespace Afina {
 namespace Network {
 namespace STcoroutine {
 
-// See Connection.h
-void Connection::Start() { std::cout << "Start" << std::endl; }
+namespace {
 
-// See Connection.h
-void Connection::OnError() { std::cout << "OnError" << std::endl; }
+// Deadline timeout after the given moment, zero timeout means there is no deadline at all
+Coroutine::Epoll::clock::time_point Deadline(Coroutine::Epoll::clock::time_point now,
+                                             std::chrono::milliseconds timeout) {
+    if (timeout.count() == 0) {
+        return Coroutine::Epoll::clock::time_point::max();
+    }
+    return now + timeout;
+}
 
-// See Connection.h
-void Connection::OnClose() { std::cout << "OnClose" << std::endl; }
+} // namespace
 
 // See Connection.h
-void Connection::DoRead() { std::cout << "DoRead" << std::endl; }
+void ServeConnection(Coroutine::Engine &engine, Coroutine::Epoll &io, int client_socket, Afina::Storage &storage,
+                     spdlog::logger &logger, std::chrono::milliseconds read_timeout) {
+    // Here is connection state
+    // - parser: parse state of the stream
+    // - command_to_execute: last command parsed out of stream
+    // - arg_remains: how many bytes to read from stream to get command argument
+    // - argument_for_command: buffer stores argument
+    std::size_t arg_remains = 0;
+    Protocol::Parser parser;
+    std::string argument_for_command;
+    std::unique_ptr<Execute::Command> command_to_execute;
 
-// See Connection.h
-void Connection::DoWrite() { std::cout << "DoWrite" << std::endl; }
+    // Deadline of the command being received, set by its first byte
+    bool in_request = false;
+    Coroutine::Epoll::clock::time_point request_deadline;
+
+    // Process connection:
+    // - read commands until socket alive
+    // - execute each command
+    // - send response
+    try {
+        int readed_bytes = -1;
+        char client_buffer[4096];
+        for (;;) {
+            auto now = Coroutine::Epoll::clock::now();
+            auto deadline = in_request ? request_deadline : Deadline(now, read_timeout);
+            readed_bytes = io.co_read(engine, client_socket, client_buffer, sizeof(client_buffer), deadline);
+            if (readed_bytes <= 0) {
+                break;
+            }
+            logger.debug("Got {} bytes from socket", readed_bytes);
+            if (!in_request) {
+                in_request = true;
+                request_deadline = Deadline(now, read_timeout);
+            }
+
+            // Single block of data readed from the socket could trigger inside actions a multiple times,
+            // for example:
+            // - read#0: [<command1 start>]
+            // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+            while (readed_bytes > 0) {
+                // There is no command yet
+                if (!command_to_execute) {
+                    std::size_t parsed = 0;
+                    if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                        logger.debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                        command_to_execute = parser.Build(arg_remains);
+                        if (arg_remains > 0) {
+                            arg_remains += 2;
+                        }
+                    }
+
+                    // Parser might fail to consume any bytes, wait for more data then
+                    if (parsed == 0) {
+                        break;
+                    } else {
+                        std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
+                        readed_bytes -= parsed;
+                    }
+                }
+
+                // There is command, but we still wait for argument to arrive...
+                if (command_to_execute && arg_remains > 0) {
+                    std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
+                    argument_for_command.append(client_buffer, to_read);
+
+                    std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
+                    arg_remains -= to_read;
+                    readed_bytes -= to_read;
+                }
+
+                // There is command & argument - RUN!
+                if (command_to_execute && arg_remains == 0) {
+                    std::string result;
+                    if (argument_for_command.size()) {
+                        argument_for_command.resize(argument_for_command.size() - 2);
+                    }
+                    command_to_execute->Execute(storage, argument_for_command, result);
+
+                    // Send response, coroutine sleeps while socket buffer is full
+                    result += "\r\n";
+                    if (io.co_write(engine, client_socket, result.data(), result.size(),
+                                    Deadline(Coroutine::Epoll::clock::now(), read_timeout)) == -1) {
+                        throw std::runtime_error("Failed to send response: " + std::string(strerror(errno)));
+                    }
+
+                    // Prepare for the next command
+                    command_to_execute.reset();
+                    argument_for_command.resize(0);
+                    parser.Reset();
+
+                    // Rest of the data starts the next command
+                    in_request = readed_bytes > 0;
+                    request_deadline = Deadline(Coroutine::Epoll::clock::now(), read_timeout);
+                }
+            } // while (readed_bytes)
+        }
+
+        if (readed_bytes == 0) {
+            logger.debug("Connection closed");
+        } else if (errno == ETIMEDOUT) {
+            logger.debug("Connection on descriptor {} timed out", client_socket);
+        } else {
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        logger.error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    }
+}
 
 } // namespace STcoroutine
 } // namespace Network
@@ -1,37 +1,32 @@
 #ifndef AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
 #define AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
 
-#include <cstring>
+#include <chrono>
 
-#include <sys/epoll.h>
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Epoll.h>
 
-namespace Afina {
-namespace Network {
-namespace STcoroutine {
-
-class Connection {
-public:
-    Connection(int s) : _socket(s) {
-        std::memset(&_event, 0, sizeof(struct epoll_event));
-        _event.data.ptr = this;
-    }
+namespace spdlog {
+class logger;
+}
 
-    inline bool isAlive() const { return true; }
-
-    void Start();
+namespace Afina {
 
-protected:
-    void OnError();
-    void OnClose();
-    void DoRead();
-    void DoWrite();
+// Forward declaration, see afina/Storage.h
+class Storage;
 
-private:
-    friend class ServerImpl;
+namespace Network {
+namespace STcoroutine {
 
-    int _socket;
-    struct epoll_event _event;
-};
+/**
+ * Body of the coroutine serving client connection: reads commands, executes them and sends responses
+ * until client closes connection, it times out or socket gets interrupted. Socket is left open, closing
+ * it is up to the caller. Shared by coroutine based servers
+ *
+ * @param read_timeout connection waiting for data or socket space longer is dropped, zero disables it
+ */
+void ServeConnection(Coroutine::Engine &engine, Coroutine::Epoll &io, int client_socket, Afina::Storage &storage,
+                     spdlog::logger &logger, std::chrono::milliseconds read_timeout);
 
 } // namespace STcoroutine
 } // namespace Network
@@ -1,6 +1,7 @@
 #include "ServerImpl.h"
 
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -19,6 +20,7 @@
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
+#include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -28,6 +30,16 @@ namespace Afina {
 namespace Network {
 namespace STcoroutine {
 
+namespace {
+
+// Connection coroutine keeps read buffer and parser on stack, commands execution and logging need some more
+const std::size_t kStackSize = 128 * 1024;
+
+// Pause of acceptor after failed accept
+const std::chrono::milliseconds kAcceptBackoff(100);
+
+} // namespace
+
 // See Server.h
 ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
 
@@ -35,9 +47,11 @@ ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Loggi
 ServerImpl::~ServerImpl() {}
 
 // See Server.h
-void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
+void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers, int backlog,
+                       std::chrono::milliseconds read_timeout) {
     _logger = pLogging->select("network");
-    _logger->info("Start st_nonblocking network service");
+    _logger->info("Start st_coroutine network service");
+    _read_timeout = read_timeout;
 
     sigset_t sig_mask;
     sigemptyset(&sig_mask);
@@ -70,7 +84,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     }
 
     make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
     }
@@ -80,6 +94,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
+    _running = true;
     _work_thread = std::thread(&ServerImpl::OnRun, this);
 }
 
@@ -87,7 +102,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
 
-    // Wakeup threads that are sleep on epoll_wait
+    // Wakeup coroutine waiting for stop signal
     if (eventfd_write(_event_fd, 1)) {
         throw std::runtime_error("Failed to wakeup workers");
     }
@@ -97,132 +112,87 @@ void ServerImpl::Stop() {
 void ServerImpl::Join() {
     // Wait for work to be complete
     _work_thread.join();
+    close(_server_socket);
+    close(_event_fd);
 }
 
 // See ServerImpl.h
 void ServerImpl::OnRun() {
-    _logger->info("Start acceptor");
-    int epoll_descr = epoll_create1(0);
-    if (epoll_descr == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
-
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.fd = _server_socket;
-    if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, _server_socket, &event)) {
-        throw std::runtime_error("Failed to add file descriptor to epoll");
-    }
-
-    struct epoll_event event2;
-    event2.events = EPOLLIN;
-    event2.data.fd = _event_fd;
-    if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, _event_fd, &event2)) {
-        throw std::runtime_error("Failed to add file descriptor to epoll");
-    }
-
-    bool run = true;
-    std::array<struct epoll_event, 64> mod_list;
-    while (run) {
-        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), -1);
-        _logger->debug("Acceptor wokeup: {} events", nmod);
-
-        for (int i = 0; i < nmod; i++) {
-            struct epoll_event &current_event = mod_list[i];
-            if (current_event.data.fd == _event_fd) {
-                _logger->debug("Break acceptor due to stop signal");
-                run = false;
-                continue;
-            } else if (current_event.data.fd == _server_socket) {
-                OnNewConnection(epoll_descr);
-                continue;
-            }
-
-            // That is some connection!
-            Connection *pc = static_cast<Connection *>(current_event.data.ptr);
-
-            auto old_mask = pc->_event.events;
-            if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                pc->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                pc->OnClose();
-            } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
-                    pc->DoRead();
-                }
-                if (current_event.events & EPOLLOUT) {
-                    pc->DoWrite();
-                }
-            }
-
-            // Does it alive?
-            if (!pc->isAlive()) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to delete connection from epoll");
-                }
-
-                close(pc->_socket);
-                pc->OnClose();
-
-                delete pc;
-            } else if (pc->_event.events != old_mask) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to change connection event mask");
+    _logger->info("Start IO thread");
 
-                    close(pc->_socket);
-                    pc->OnClose();
+    // Epoll is waited for only when all coroutines are blocked on sockets
+    Coroutine::Epoll io;
+    Coroutine::Engine engine([&io](Coroutine::Engine &pe) { io.Poll(pe); },
+                             Coroutine::Engine::StackMode::FixedStack, kStackSize);
+    engine.start(&ServerImpl::OnAccept, this, engine, io);
 
-                    delete pc;
-                }
-            }
-        }
-    }
-    _logger->warn("Acceptor stopped");
+    auto stats = engine.GetStats();
+    _logger->warn("IO thread stopped, {} coroutines at most, {} stacks created", stats.in_use_max, stats.created);
 }
 
-void ServerImpl::OnNewConnection(int epoll_descr) {
-    for (;;) {
+// See ServerImpl.h
+void ServerImpl::OnAccept(ServerImpl *self, Coroutine::Engine &engine, Coroutine::Epoll &io) {
+    engine.run(&ServerImpl::OnStop, std::move(self), engine, io);
+
+    while (self->_running) {
         struct sockaddr in_addr;
-        socklen_t in_len;
-
-        // No need to make these sockets non blocking since accept4() takes care of it.
-        in_len = sizeof in_addr;
-        int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
-        if (infd == -1) {
-            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
-                break; // We have processed all incoming connections.
-            } else {
-                _logger->error("Failed to accept socket");
-                break;
+        socklen_t in_len = sizeof(in_addr);
+        int client_socket = io.co_accept(engine, self->_server_socket, &in_addr, &in_len);
+        if (client_socket == -1) {
+            if (self->_running) {
+                // Error like EMFILE could go away once some connection is closed, let them run meanwhile.
+                // Acceptor might be the only runnable coroutine, so it sleeps rather than yields
+                self->_logger->error("Failed to accept socket: {}", strerror(errno));
+                io.sleep_for(engine, kAcceptBackoff);
             }
+            continue;
         }
 
         // Print host and service info.
-        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-        int retval =
-            getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV);
-        if (retval == 0) {
-            _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
+        if (self->_logger->should_log(spdlog::level::debug)) {
+            char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+            if (getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV) ==
+                0) {
+                self->_logger->debug("Accepted connection on descriptor {} (host={}, port={})", client_socket, hbuf,
+                                     sbuf);
+            }
         }
 
-        // Register the new FD to be monitored by epoll.
-        Connection *pc = new (std::nothrow) Connection(infd);
-        if (pc == nullptr) {
-            throw std::runtime_error("Failed to allocate connection");
+        self->_connections.insert(client_socket);
+        if (engine.run(&ServerImpl::OnConnection, std::move(self), engine, io, std::move(client_socket)) == nullptr) {
+            self->_logger->error("Failed to start coroutine for descriptor {}", client_socket);
+            self->_connections.erase(client_socket);
+            io.co_close(client_socket);
         }
+    }
+    self->_logger->debug("Acceptor stopped");
+}
 
-        // Register connection in worker's epoll
-        pc->Start();
-        if (pc->isAlive()) {
-            if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
-                pc->OnError();
-                delete pc;
-            }
-        }
+// See ServerImpl.h
+void ServerImpl::OnStop(ServerImpl *self, Coroutine::Engine &engine, Coroutine::Epoll &io) {
+    eventfd_t value;
+    if (io.co_read(engine, self->_event_fd, &value, sizeof(value)) != sizeof(value)) {
+        self->_logger->error("Failed to read stop signal: {}", strerror(errno));
+    }
+
+    // Acceptor wakes up with error, connections stop reading new commands but still send responses for the
+    // current ones
+    self->_running = false;
+    shutdown(self->_server_socket, SHUT_RDWR);
+    for (int client_socket : self->_connections) {
+        shutdown(client_socket, SHUT_RD);
     }
 }
 
+// See ServerImpl.h
+void ServerImpl::OnConnection(ServerImpl *self, Coroutine::Engine &engine, Coroutine::Epoll &io, int client_socket) {
+    ServeConnection(engine, io, client_socket, *self->pStorage, *self->_logger, self->_read_timeout);
+
+    // We are done with this connection
+    self->_connections.erase(client_socket);
+    io.co_close(client_socket);
+}
+
 } // namespace STcoroutine
 } // namespace Network
 } // namespace Afina
@@ -1,9 +1,12 @@
 #ifndef AFINA_NETWORK_ST_COROUTINE_SERVER_H
 #define AFINA_NETWORK_ST_COROUTINE_SERVER_H
 
+#include <set>
 #include <thread>
 #include <vector>
 
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Epoll.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -14,12 +17,11 @@ namespace Afina {
 namespace Network {
 namespace STcoroutine {
 
-// Forward declaration, see Worker.h
-class Worker;
-
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Single threaded server where each connection is served by own coroutine. Connection code is written
+ * as if sockets were blocking, coroutine waiting for socket gives up control to others, see
+ * Coroutine::Epoll
  */
 class ServerImpl : public Server {
 public:
@@ -27,7 +29,8 @@ public:
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers, int backlog,
+               std::chrono::milliseconds read_timeout) override;
 
     // See Server.h
     void Stop() override;
@@ -36,8 +39,25 @@ public:
     void Join() override;
 
 protected:
+    /**
+     * Method is running in the IO thread, runs coroutines until all of them are done
+     */
     void OnRun();
-    void OnNewConnection(int);
+
+    /**
+     * Main coroutine: accepts connections and starts coroutine for each
+     */
+    static void OnAccept(ServerImpl *self, Coroutine::Engine &engine, Coroutine::Epoll &io);
+
+    /**
+     * Coroutine waiting for stop signal, interrupts all others once it arrives
+     */
+    static void OnStop(ServerImpl *self, Coroutine::Engine &engine, Coroutine::Epoll &io);
+
+    /**
+     * Coroutine serving the given connection until client closes it or server stops
+     */
+    static void OnConnection(ServerImpl *self, Coroutine::Engine &engine, Coroutine::Epoll &io, int client_socket);
 
 private:
     // logger to use
@@ -48,12 +68,21 @@ private:
     // Read-only
     uint16_t listen_port;
 
+    // Connection waiting for data or socket space longer is closed, zero if there is no timeout. Read-only
+    std::chrono::milliseconds _read_timeout;
+
     // Socket to accept new connection on, shared between acceptors
     int _server_socket;
 
     // Curstom event "device" used to wakeup workers
     int _event_fd;
 
+    // Server is accepting connections, accessed from IO thread only
+    bool _running;
+
+    // Sockets of connections currently served, accessed from IO thread only
+    std::set<int> _connections;
+
     // IO thread
     std::thread _work_thread;
 };
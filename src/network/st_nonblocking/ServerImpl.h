@@ -27,7 +27,8 @@ public:
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers, int backlog,
+               std::chrono::milliseconds read_timeout) override;
 
     // See Server.h
     void Stop() override;
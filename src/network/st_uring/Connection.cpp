@@ -0,0 +1,96 @@
+#include "Connection.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Network {
+namespace STuring {
+
+namespace {
+
+// Longest command line parser could get stuck on
+const std::size_t kMaxTail = 4096;
+
+} // namespace
+
+// See Connection.h
+Connection::~Connection() { close(_socket); }
+
+// See Connection.h
+void Connection::Process(const char *data, std::size_t size) {
+    // Glue with the tail left from the previous call
+    std::string joined;
+    if (!_tail.empty()) {
+        joined.swap(_tail);
+        joined.append(data, size);
+        data = joined.data();
+        size = joined.size();
+    }
+
+    // Responses to commands of one recv go out by one send
+    std::string responses;
+    std::size_t pos = 0;
+    while (pos < size) {
+        // There is no command yet
+        if (!_command_to_execute) {
+            std::size_t parsed = 0;
+            if (_parser.Parse(data + pos, size - pos, parsed)) {
+                _logger->debug("Found new command: {} in {} bytes", _parser.Name(), parsed);
+                _command_to_execute = _parser.Build(_arg_remains);
+                if (_arg_remains > 0) {
+                    _arg_remains += 2;
+                }
+            }
+
+            // Parser might fail to consume any bytes, wait for more data then
+            if (parsed == 0) {
+                break;
+            }
+            pos += parsed;
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (_command_to_execute && _arg_remains > 0) {
+            std::size_t to_read = std::min(_arg_remains, size - pos);
+            _argument_for_command.append(data + pos, to_read);
+            _arg_remains -= to_read;
+            pos += to_read;
+        }
+
+        // There is command & argument - RUN!
+        if (_command_to_execute && _arg_remains == 0) {
+            std::string result;
+            if (_argument_for_command.size()) {
+                _argument_for_command.resize(_argument_for_command.size() - 2);
+            }
+            _command_to_execute->Execute(*_pStorage, _argument_for_command, result);
+            responses += result;
+            responses += "\r\n";
+
+            // Prepare for the next command
+            _command_to_execute.reset();
+            _argument_for_command.resize(0);
+            _parser.Reset();
+        }
+    }
+
+    if (!responses.empty()) {
+        _output.push_back(std::move(responses));
+    }
+
+    _tail.assign(data + pos, size - pos);
+    if (_tail.size() >= kMaxTail) {
+        throw std::runtime_error("Command is too long");
+    }
+}
+
+} // namespace STuring
+} // namespace Network
+} // namespace Afina
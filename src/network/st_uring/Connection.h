@@ -0,0 +1,86 @@
+#ifndef AFINA_NETWORK_ST_URING_CONNECTION_H
+#define AFINA_NETWORK_ST_URING_CONNECTION_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <afina/execute/Command.h>
+
+#include "protocol/Parser.h"
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
+namespace Network {
+namespace STuring {
+
+/**
+ * # Client connection
+ * Protocol state of the connection and ring operations it has in flight. Connection is deleted by
+ * server once kernel doesn't reference its socket or responses anymore
+ */
+class Connection {
+public:
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+        : _socket(s), _pStorage(ps), _logger(pl), _receiving(false), _cancelling(false), _eof(false),
+          _failed(false), _sending(0), _arg_remains(0), _head_written(0) {}
+
+    ~Connection();
+
+    /**
+     * Parses and executes all complete commands in the received data, their responses are queued to _output
+     * as one buffer. Incomplete tail is kept till the next call
+     */
+    void Process(const char *data, std::size_t size);
+
+private:
+    friend class ServerImpl;
+
+    int _socket;
+
+    std::shared_ptr<Afina::Storage> _pStorage;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Multishot recv is armed
+    bool _receiving;
+
+    // Cancel for recv is submitted
+    bool _cancelling;
+
+    // Nothing is read from the socket anymore
+    bool _eof;
+
+    // Send failed, queued responses are dropped
+    bool _failed;
+
+    // Number of linked sends in flight
+    unsigned _sending;
+
+    // Received bytes parser didn't consume
+    std::string _tail;
+
+    // Command being received, see st_blocking
+    Protocol::Parser _parser;
+    std::unique_ptr<Execute::Command> _command_to_execute;
+    std::size_t _arg_remains;
+    std::string _argument_for_command;
+
+    // Buffers of responses waiting to be sent and how much of the first one is sent already. Sends in flight
+    // point to the first elements, deque never moves them
+    std::deque<std::string> _output;
+    std::size_t _head_written;
+};
+
+} // namespace STuring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_ST_URING_CONNECTION_H
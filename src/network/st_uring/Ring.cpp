@@ -0,0 +1,196 @@
+#include "Ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+namespace STuring {
+
+namespace {
+
+// Kernel must not drop completions and must poll sockets itself instead of punting ops to worker threads
+const uint32_t kRequiredFeatures = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL;
+
+inline int io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return int(syscall(__NR_io_uring_setup, entries, p));
+}
+
+inline int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return int(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+inline int io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return int(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+} // namespace
+
+// See Ring.h
+Ring::Ring(unsigned entries, unsigned buffers, std::size_t buffer_size)
+    : _fd(-1), _sq_ptr(MAP_FAILED), _sq_size(0), _to_submit(0), _sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)),
+      _sqes_size(0), _buf_ring(static_cast<struct io_uring_buf_ring *>(MAP_FAILED)), _buf_ring_size(0),
+      _buf_mask(buffers - 1), _buf_tail(0), _buffers(static_cast<char *>(MAP_FAILED)), _buffer_size(buffer_size) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    // Destructor isn't called if constructor throws
+    auto fail = [this](const std::string &what) {
+        std::string msg = what + ": " + strerror(errno);
+        this->Release();
+        throw std::runtime_error(msg);
+    };
+
+    _fd = io_uring_setup(entries, &params);
+    if (_fd == -1) {
+        fail("io_uring_setup failed");
+    }
+    if ((params.features & kRequiredFeatures) != kRequiredFeatures) {
+        errno = ENOTSUP;
+        fail("io_uring lacks required features");
+    }
+
+    // Both queues are in one mapping
+    _sq_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+    _sq_ptr = mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sq_ptr == MAP_FAILED) {
+        fail("Failed to map io_uring queues");
+    }
+
+    _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    _sqes = static_cast<struct io_uring_sqe *>(
+        mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES));
+    if (_sqes == MAP_FAILED) {
+        fail("Failed to map io_uring submission entries");
+    }
+
+    char *base = static_cast<char *>(_sq_ptr);
+    _sq_head = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+    _sq_ktail = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+    _sq_array = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+    _sq_mask = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+    _sq_entries = params.sq_entries;
+    _sq_tail = *_sq_ktail;
+
+    _cq_head = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+    _cq_mask = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<struct io_uring_cqe *>(base + params.cq_off.cqes);
+
+    // Provided buffers ring must be page aligned, anonymous mapping is
+    _buf_ring_size = buffers * sizeof(struct io_uring_buf);
+    _buf_ring = static_cast<struct io_uring_buf_ring *>(
+        mmap(nullptr, _buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0));
+    if (_buf_ring == MAP_FAILED) {
+        fail("Failed to map provided buffers ring");
+    }
+
+    _buffers = static_cast<char *>(mmap(nullptr, buffers * _buffer_size, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0));
+    if (_buffers == MAP_FAILED) {
+        fail("Failed to map provided buffers");
+    }
+
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(_buf_ring);
+    reg.ring_entries = buffers;
+    reg.bgid = kBufferGroup;
+    if (io_uring_register(_fd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1) {
+        fail("Failed to register provided buffers");
+    }
+
+    for (unsigned bid = 0; bid < buffers; bid++) {
+        ReturnBuffer(uint16_t(bid));
+    }
+}
+
+// See Ring.h
+Ring::~Ring() { Release(); }
+
+// See Ring.h
+void Ring::Release() {
+    if (_buffers != MAP_FAILED) {
+        munmap(_buffers, (_buf_mask + 1) * _buffer_size);
+    }
+    if (_buf_ring != MAP_FAILED) {
+        munmap(_buf_ring, _buf_ring_size);
+    }
+    if (_sqes != MAP_FAILED) {
+        munmap(_sqes, _sqes_size);
+    }
+    if (_sq_ptr != MAP_FAILED) {
+        munmap(_sq_ptr, _sq_size);
+    }
+    if (_fd != -1) {
+        close(_fd);
+    }
+}
+
+// See Ring.h
+struct io_uring_sqe *Ring::GetSQE() {
+    if (_sq_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) >= _sq_entries) {
+        Enter(0);
+        if (_sq_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) >= _sq_entries) {
+            throw std::runtime_error("io_uring submission queue is full");
+        }
+    }
+
+    unsigned idx = _sq_tail & _sq_mask;
+    struct io_uring_sqe *sqe = &_sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sq_array[idx] = idx;
+    _sq_tail++;
+    _to_submit++;
+    return sqe;
+}
+
+// See Ring.h
+void Ring::Reserve(unsigned count) {
+    if (_sq_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) + count > _sq_entries) {
+        Enter(0);
+    }
+}
+
+// See Ring.h
+bool Ring::Enter(unsigned wait_nr) {
+    __atomic_store_n(_sq_ktail, _sq_tail, __ATOMIC_RELEASE);
+    int ret = io_uring_enter(_fd, _to_submit, wait_nr, wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (ret == -1) {
+        if (errno == EINTR) {
+            return false;
+        }
+
+        // Completion queue is full, caller must consume completions before kernel takes more
+        if (errno == EBUSY || errno == EAGAIN) {
+            return true;
+        }
+        throw std::runtime_error("io_uring_enter failed: " + std::string(strerror(errno)));
+    }
+    _to_submit -= unsigned(ret);
+    return true;
+}
+
+// See Ring.h
+void Ring::ReturnBuffer(uint16_t bid) {
+    // Entries start at the beginning of the ring. Header's bufs member can't be used, in C++ flexible array
+    // macro puts it after one byte sized empty struct
+    struct io_uring_buf *buf = reinterpret_cast<struct io_uring_buf *>(_buf_ring) + (_buf_tail & _buf_mask);
+    buf->addr = reinterpret_cast<uint64_t>(Buffer(bid));
+    buf->len = uint32_t(_buffer_size);
+    buf->bid = bid;
+    _buf_tail++;
+    __atomic_store_n(&_buf_ring->tail, _buf_tail, __ATOMIC_RELEASE);
+}
+
+} // namespace STuring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,122 @@
+#ifndef AFINA_NETWORK_ST_URING_RING_H
+#define AFINA_NETWORK_ST_URING_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <linux/io_uring.h>
+
+namespace Afina {
+namespace Network {
+namespace STuring {
+
+/**
+ * # io_uring instance
+ * Thin wrapper over raw io_uring syscalls, so there is no dependency on liburing. Owns submission and
+ * completion queues mapped from kernel and a ring of provided buffers the kernel picks from for
+ * recv with IOSQE_BUFFER_SELECT.
+ *
+ * Entries taken by GetSQE are passed to kernel by the next Enter, which also waits for completions, so
+ * one syscall covers everything queued since the previous one. Not thread safe.
+ */
+class Ring {
+public:
+    /**
+     * Creates ring, throws std::runtime_error if kernel doesn't support io_uring or some of features
+     * server relies on
+     *
+     * @param entries size of submission queue, rounded up to power of 2 by kernel
+     * @param buffers number of provided buffers, must be power of 2
+     * @param buffer_size size of each provided buffer
+     */
+    Ring(unsigned entries, unsigned buffers, std::size_t buffer_size);
+    ~Ring();
+
+    /**
+     * Returns zeroed submission entry, flushing queue to kernel if it is full
+     */
+    struct io_uring_sqe *GetSQE();
+
+    /**
+     * Makes sure next count GetSQE calls don't flush queue, so that linked entries are submitted together
+     */
+    void Reserve(unsigned count);
+
+    /**
+     * Submits queued entries and waits until there is at least wait_nr completions. Returns false if
+     * wait was interrupted by signal
+     */
+    bool Enter(unsigned wait_nr);
+
+    /**
+     * Calls handler for each completion ready and marks them as consumed
+     */
+    template <typename F> void ForEachCQE(F handler) {
+        unsigned head = *_cq_head;
+        unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            handler(_cqes[head & _cq_mask]);
+        }
+        __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Group id of provided buffers to set in sqe->buf_group
+     */
+    static const uint16_t kBufferGroup = 0;
+
+    /**
+     * Provided buffer by its id taken from cqe->flags
+     */
+    char *Buffer(uint16_t bid) { return _buffers + std::size_t(bid) * _buffer_size; }
+
+    /**
+     * Gives buffer back to kernel once its data is processed
+     */
+    void ReturnBuffer(uint16_t bid);
+
+private:
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    /**
+     * Unmaps everything mapped so far and closes ring
+     */
+    void Release();
+
+    int _fd;
+
+    // Submission queue, sq_tail is local until Enter publishes it
+    void *_sq_ptr;
+    std::size_t _sq_size;
+    unsigned *_sq_head;
+    unsigned *_sq_ktail;
+    unsigned *_sq_array;
+    unsigned _sq_mask;
+    unsigned _sq_entries;
+    unsigned _sq_tail;
+    unsigned _to_submit;
+    struct io_uring_sqe *_sqes;
+    std::size_t _sqes_size;
+
+    // Completion queue, shares mapping with submission one
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    struct io_uring_cqe *_cqes;
+
+    // Provided buffers ring and memory of buffers
+    struct io_uring_buf_ring *_buf_ring;
+    std::size_t _buf_ring_size;
+    unsigned _buf_mask;
+    uint16_t _buf_tail;
+    char *_buffers;
+    std::size_t _buffer_size;
+};
+
+} // namespace STuring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_ST_URING_RING_H
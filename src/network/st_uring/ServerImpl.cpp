@@ -0,0 +1,430 @@
+#include "ServerImpl.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/logging/Service.h>
+
+#include "Connection.h"
+#include "Ring.h"
+#include "network/mt_nonblocking/ServerImpl.h"
+
+namespace Afina {
+namespace Network {
+namespace STuring {
+
+namespace {
+
+const unsigned kRingEntries = 256;
+
+// Provided buffers shared by all connections, one is busy only while its data is parsed
+const unsigned kBuffers = 256;
+const std::size_t kBufferSize = 4096;
+
+// Client pipelining faster than it reads responses isn't read from until queue drains
+const std::size_t kMaxOutput = 1024;
+
+// Response buffers sent by one chain of linked sends
+const std::size_t kMaxLinked = 64;
+
+// Connections are allocated with new, so low bits of pointer are free for operation
+const uint64_t kOpMask = 7;
+
+inline uint64_t pack(Connection *pc, uint64_t op) { return reinterpret_cast<uint64_t>(pc) | op; }
+
+// Multishot recv came to kernel later than provided buffers rings, older kernels fail it with EINVAL
+void probe_recv_multishot(Ring &ring) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+        throw std::runtime_error("Failed to create socket pair: " + std::string(strerror(errno)));
+    }
+    if (write(fds[1], "x", 1) != 1 || shutdown(fds[1], SHUT_WR) == -1) {
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error("Failed to write to socket pair: " + std::string(strerror(errno)));
+    }
+
+    struct io_uring_sqe *sqe = ring.GetSQE();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fds[0];
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = Ring::kBufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+
+    // Supported recv gets data and stays armed, then gets end of stream
+    bool supported = false, done = false;
+    while (!done) {
+        if (!ring.Enter(1)) {
+            continue;
+        }
+        ring.ForEachCQE([&](const struct io_uring_cqe &cqe) {
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                ring.ReturnBuffer(uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+            }
+            if (cqe.flags & IORING_CQE_F_MORE) {
+                supported = true;
+            } else {
+                done = true;
+            }
+        });
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    if (!supported) {
+        throw std::runtime_error("multishot recv isn't supported");
+    }
+}
+
+} // namespace
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), _server_socket(-1), _event_fd(-1), _running(false), _accepting(false), _waiting_stop(false) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers, int backlog,
+                       std::chrono::milliseconds read_timeout) {
+    _logger = pLogging->select("network");
+
+    try {
+        _ring.reset(new Ring(kRingEntries, kBuffers, kBufferSize));
+        probe_recv_multishot(*_ring);
+    } catch (std::runtime_error &ex) {
+        _ring.reset();
+        _logger->warn("io_uring can't be used ({}), fall back to epoll", ex.what());
+        // Storage is accessed by one thread, the same as with io_uring, so thread unsafe storage still works
+        _fallback = std::make_shared<MTnonblock::ServerImpl>(pStorage, pLogging);
+        _fallback->Start(port, 1, 1, backlog, read_timeout);
+        return;
+    }
+    _logger->info("Start st_uring network service");
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    // Create server socket
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;         // IPv4
+    server_addr.sin_port = htons(port);       // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+    _server_socket = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (_server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    if (listen(_server_socket, backlog) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _running = true;
+    _work_thread = std::thread(&ServerImpl::OnRun, this);
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    if (_fallback) {
+        _fallback->Stop();
+        return;
+    }
+    _logger->warn("Stop network service");
+
+    // Wakeup IO thread waiting for stop signal
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup IO thread");
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    if (_fallback) {
+        _fallback->Join();
+        return;
+    }
+
+    // Wait for work to be complete
+    _work_thread.join();
+    _ring.reset();
+    close(_server_socket);
+    close(_event_fd);
+}
+
+// See ServerImpl.h
+void ServerImpl::OnRun() {
+    _logger->info("Start IO thread");
+    try {
+        ArmAccept();
+        ArmStop();
+        while (_accepting || _waiting_stop || !_connections.empty()) {
+            // Submits everything armed by the previous round and waits for the next one
+            if (!_ring->Enter(1)) {
+                continue;
+            }
+
+            _ring->ForEachCQE([this](const struct io_uring_cqe &cqe) {
+                Connection *pc = reinterpret_cast<Connection *>(cqe.user_data & ~kOpMask);
+                switch (cqe.user_data & kOpMask) {
+                case kAccept:
+                    OnAccept(cqe);
+                    break;
+                case kStop:
+                    OnStop();
+                    break;
+                case kRecv:
+                    OnRecv(pc, cqe);
+                    break;
+                case kSend:
+                    OnSend(pc, cqe);
+                    break;
+                default:
+                    // Result of cancel isn't interesting, cancelled operation completes by itself
+                    break;
+                }
+            });
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("IO thread failed: {}", ex.what());
+    }
+
+    for (Connection *pc : _connections) {
+        delete pc;
+    }
+    _connections.clear();
+    _logger->warn("IO thread stopped");
+}
+
+// See ServerImpl.h
+void ServerImpl::ArmAccept() {
+    struct io_uring_sqe *sqe = _ring->GetSQE();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _server_socket;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = kAccept;
+    _accepting = true;
+}
+
+// See ServerImpl.h
+void ServerImpl::ArmStop() {
+    struct io_uring_sqe *sqe = _ring->GetSQE();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = _event_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&_event_value);
+    sqe->len = sizeof(_event_value);
+    sqe->user_data = kStop;
+    _waiting_stop = true;
+}
+
+// See ServerImpl.h
+void ServerImpl::ArmRecv(Connection *pc) {
+    struct io_uring_sqe *sqe = _ring->GetSQE();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = pc->_socket;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = Ring::kBufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = pack(pc, kRecv);
+    pc->_receiving = true;
+}
+
+// See ServerImpl.h
+void ServerImpl::Cancel(uint64_t user_data) {
+    struct io_uring_sqe *sqe = _ring->GetSQE();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = user_data;
+    sqe->user_data = kCancel;
+}
+
+// See ServerImpl.h
+void ServerImpl::Send(Connection *pc) {
+    if (pc->_sending > 0 || pc->_failed || pc->_output.empty()) {
+        return;
+    }
+
+    // Chain keeps responses order and stops at the first short send, the rest is sent by the next chain
+    unsigned count = unsigned(std::min(pc->_output.size(), kMaxLinked));
+    _ring->Reserve(count);
+    for (unsigned i = 0; i < count; i++) {
+        const std::string &response = pc->_output[i];
+        std::size_t offset = i == 0 ? pc->_head_written : 0;
+
+        struct io_uring_sqe *sqe = _ring->GetSQE();
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = pc->_socket;
+        sqe->addr = reinterpret_cast<uint64_t>(response.data() + offset);
+        sqe->len = uint32_t(response.size() - offset);
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        if (i + 1 < count) {
+            sqe->flags = IOSQE_IO_LINK;
+        }
+        sqe->user_data = pack(pc, kSend);
+    }
+    pc->_sending = count;
+}
+
+// See ServerImpl.h
+void ServerImpl::OnAccept(const struct io_uring_cqe &cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        _accepting = false;
+    }
+
+    if (cqe.res >= 0) {
+        if (_running) {
+            _logger->debug("Accepted connection on descriptor {}", cqe.res);
+            Connection *pc = new Connection(cqe.res, pStorage, _logger);
+            _connections.insert(pc);
+            ArmRecv(pc);
+        } else {
+            close(cqe.res);
+        }
+    } else if (cqe.res != -ECANCELED) {
+        _logger->error("Failed to accept socket: {}", strerror(-cqe.res));
+    }
+
+    // Multishot accept stops on errors
+    if (!_accepting && _running) {
+        ArmAccept();
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::OnStop() {
+    _waiting_stop = false;
+    _running = false;
+    if (_accepting) {
+        Cancel(kAccept);
+    }
+
+    // Connections stop reading new commands but still send responses for the current ones
+    std::vector<Connection *> connections(_connections.begin(), _connections.end());
+    for (Connection *pc : connections) {
+        pc->_eof = true;
+        Update(pc);
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::OnRecv(Connection *pc, const struct io_uring_cqe &cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        pc->_receiving = false;
+        pc->_cancelling = false;
+    }
+
+    if (cqe.res > 0) {
+        uint16_t bid = uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (!pc->_eof) {
+            _logger->debug("Got {} bytes from socket {}", cqe.res, pc->_socket);
+            try {
+                pc->Process(_ring->Buffer(bid), std::size_t(cqe.res));
+            } catch (std::runtime_error &ex) {
+                _logger->error("Failed to process connection on descriptor {}: {}", pc->_socket, ex.what());
+                pc->_output.emplace_back(std::string("SERVER_ERROR ") + ex.what() + "\r\n");
+                pc->_eof = true;
+            }
+        }
+        _ring->ReturnBuffer(bid);
+        Send(pc);
+    } else if (cqe.res == 0) {
+        _logger->debug("Client closed descriptor {}", pc->_socket);
+        pc->_eof = true;
+    } else if (cqe.res == -ENOBUFS) {
+        // All buffers are taken by completions not processed yet, recv is rearmed below
+        _logger->debug("No buffers for descriptor {}", pc->_socket);
+    } else if (cqe.res != -ECANCELED) {
+        _logger->error("Failed to read from descriptor {}: {}", pc->_socket, strerror(-cqe.res));
+        pc->_eof = true;
+    }
+
+    Update(pc);
+}
+
+// See ServerImpl.h
+void ServerImpl::OnSend(Connection *pc, const struct io_uring_cqe &cqe) {
+    pc->_sending--;
+    if (cqe.res >= 0) {
+        std::size_t left = pc->_output.front().size() - pc->_head_written;
+        if (std::size_t(cqe.res) < left) {
+            pc->_head_written += cqe.res;
+        } else {
+            pc->_output.pop_front();
+            pc->_head_written = 0;
+        }
+    } else if (cqe.res != -ECANCELED) {
+        _logger->error("Failed to write to descriptor {}: {}", pc->_socket, strerror(-cqe.res));
+        pc->_failed = true;
+        pc->_eof = true;
+    }
+
+    // Chain is over, either all responses are sent or the rest goes with the next chain
+    if (pc->_sending == 0) {
+        if (pc->_failed) {
+            pc->_output.clear();
+            pc->_head_written = 0;
+        } else {
+            Send(pc);
+        }
+    }
+
+    Update(pc);
+}
+
+// See ServerImpl.h
+void ServerImpl::Update(Connection *pc) {
+    bool want_read = !pc->_eof && pc->_output.size() < kMaxOutput;
+    if (pc->_receiving && !want_read && !pc->_cancelling) {
+        Cancel(pack(pc, kRecv));
+        pc->_cancelling = true;
+    } else if (!pc->_receiving && want_read) {
+        ArmRecv(pc);
+    }
+
+    if (!pc->_receiving && pc->_eof && pc->_sending == 0 && pc->_output.empty()) {
+        _logger->debug("Connection on descriptor {} closed", pc->_socket);
+        _connections.erase(pc);
+        delete pc;
+    }
+}
+
+} // namespace STuring
+} // namespace Network
+} // namespace Afina
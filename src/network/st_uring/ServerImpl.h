@@ -0,0 +1,116 @@
+#ifndef AFINA_NETWORK_ST_URING_SERVER_H
+#define AFINA_NETWORK_ST_URING_SERVER_H
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+#include <afina/network/Server.h>
+
+struct io_uring_cqe;
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace STuring {
+
+// Forward declaration, see Connection.h and Ring.h
+class Connection;
+class Ring;
+
+/**
+ * # Network resource manager implementation
+ * Single threaded server on io_uring. Listening socket has multishot accept armed, each connection has
+ * multishot recv into kernel provided buffers. Responses produced by one recv are sent by one send, ones
+ * queued while sends are in flight go next as a chain of linked sends. Operations are armed once and keep
+ * producing completions, so one io_uring_enter submits and reaps everything for all connections and there
+ * are no rearms per event.
+ *
+ * If kernel lacks io_uring or features it relies on, server works as MTnonblock one with single worker
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers, int backlog,
+               std::chrono::milliseconds read_timeout) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+protected:
+    /**
+     * Method is running in the IO thread, submits and reaps ring operations until all connections are done
+     */
+    void OnRun();
+
+private:
+    // Operation completion belongs to, kept in low bits of user_data
+    enum Op : uint64_t { kAccept = 1, kStop, kCancel, kRecv, kSend };
+
+    void ArmAccept();
+    void ArmStop();
+    void ArmRecv(Connection *pc);
+    void Cancel(uint64_t user_data);
+
+    /**
+     * Submits linked sends for queued responses unless some are in flight already
+     */
+    void Send(Connection *pc);
+
+    void OnAccept(const struct io_uring_cqe &cqe);
+    void OnStop();
+    void OnRecv(Connection *pc, const struct io_uring_cqe &cqe);
+    void OnSend(Connection *pc, const struct io_uring_cqe &cqe);
+
+    /**
+     * Pauses or resumes reading according to the connection state and deletes connection once it is done
+     */
+    void Update(Connection *pc);
+
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Epoll based server used if io_uring can't be
+    std::shared_ptr<Server> _fallback;
+
+    // Socket to accept new connection on
+    int _server_socket;
+
+    // Curstom event "device" used to wakeup IO thread
+    int _event_fd;
+
+    // Value read from _event_fd
+    uint64_t _event_value;
+
+    // Ring of the IO thread
+    std::unique_ptr<Ring> _ring;
+
+    // Server is accepting connections, accessed from IO thread only
+    bool _running;
+
+    // Multishot accept and stop signal read are armed
+    bool _accepting;
+    bool _waiting_stop;
+
+    // Connections alive, accessed from IO thread only
+    std::unordered_set<Connection *> _connections;
+
+    // IO thread
+    std::thread _work_thread;
+};
+
+} // namespace STuring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_ST_URING_SERVER_H
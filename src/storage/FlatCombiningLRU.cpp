@@ -0,0 +1,89 @@
+#include "FlatCombiningLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+// See FlatCombiningLRU.h
+FlatCombiningLRU::FlatCombiningLRU(size_t max_size)
+    : _storage(max_size), _combiner([this](lru_op &op) { _apply(op); }) {}
+
+// See FlatCombiningLRU.h
+FlatCombiningLRU::FlatCombiningLRU(std::shared_ptr<Allocator::Arena> arena)
+    : _storage(arena), _combiner([this](lru_op &op) { _apply(op); }) {}
+
+// See MapBasedGlobalLockImpl.h
+bool FlatCombiningLRU::Put(const std::string &key, const std::string &value) {
+    return _execute(lru_op::Type::kPut, &key, &value, nullptr);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool FlatCombiningLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return _execute(lru_op::Type::kPutIfAbsent, &key, &value, nullptr);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool FlatCombiningLRU::Set(const std::string &key, const std::string &value) {
+    return _execute(lru_op::Type::kSet, &key, &value, nullptr);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool FlatCombiningLRU::Delete(const std::string &key) {
+    return _execute(lru_op::Type::kDelete, &key, nullptr, nullptr);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool FlatCombiningLRU::Get(const std::string &key, std::string &value) {
+    return _execute(lru_op::Type::kGet, &key, nullptr, &value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool FlatCombiningLRU::Get(const std::string &key, Value &value) {
+    lru_op op{lru_op::Type::kGetValue, &key, nullptr, nullptr, &value, nullptr, false};
+    _combiner.Execute(op);
+    return op.result;
+}
+
+// See FlatCombiningLRU.h
+void FlatCombiningLRU::GetStats(std::vector<std::pair<std::string, std::string>> &stats) {
+    lru_op op{lru_op::Type::kStats, nullptr, nullptr, nullptr, nullptr, &stats, false};
+    _combiner.Execute(op);
+}
+
+// See FlatCombiningLRU.h
+bool FlatCombiningLRU::_execute(lru_op::Type type, const std::string *key, const std::string *value,
+                                std::string *out) {
+    lru_op op{type, key, value, out, nullptr, nullptr, false};
+    _combiner.Execute(op);
+    return op.result;
+}
+
+// See FlatCombiningLRU.h
+void FlatCombiningLRU::_apply(lru_op &op) {
+    switch (op.type) {
+    case lru_op::Type::kPut:
+        op.result = _storage.Put(*op.key, *op.value);
+        break;
+    case lru_op::Type::kPutIfAbsent:
+        op.result = _storage.PutIfAbsent(*op.key, *op.value);
+        break;
+    case lru_op::Type::kSet:
+        op.result = _storage.Set(*op.key, *op.value);
+        break;
+    case lru_op::Type::kDelete:
+        op.result = _storage.Delete(*op.key);
+        break;
+    case lru_op::Type::kGet:
+        op.result = _storage.Get(*op.key, *op.out);
+        break;
+    case lru_op::Type::kGetValue:
+        op.result = _storage.Get(*op.key, *op.handle);
+        break;
+    case lru_op::Type::kStats:
+        _storage.GetStats(*op.stats);
+        op.result = true;
+        break;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,87 @@
+#ifndef AFINA_STORAGE_FLAT_COMBINING_LRU_H
+#define AFINA_STORAGE_FLAT_COMBINING_LRU_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Arena.h>
+#include <afina/concurrency/FlatCombine.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Flat combining LRU
+ * Thread safe SimpleLRU that keeps the strict global LRU order. Instead of taking a global lock
+ * each operation is published and applied by the combiner thread together with operations of
+ * other threads, see Concurrency::FlatCombine
+ */
+class FlatCombiningLRU : public Afina::Storage {
+public:
+    FlatCombiningLRU(size_t max_size = 1024);
+    FlatCombiningLRU(std::shared_ptr<Allocator::Arena> arena);
+    ~FlatCombiningLRU() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface
+    void GetStats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Operation published by the caller thread
+    struct lru_op {
+        enum class Type { kPut, kPutIfAbsent, kSet, kDelete, kGet, kGetValue, kStats };
+
+        Type type;
+        const std::string *key;
+        const std::string *value;
+
+        // Output of Get
+        std::string *out;
+
+        // Output of Get for value handle
+        Value *handle;
+
+        // Output of GetStats
+        std::vector<std::pair<std::string, std::string>> *stats;
+
+        bool result;
+    };
+
+    // Publish and wait for the operation
+    bool _execute(lru_op::Type type, const std::string *key, const std::string *value, std::string *out);
+
+    // Applies operation to the storage, called by combiner
+    void _apply(lru_op &op);
+
+    // Underlaying storage, accessed by combiner only
+    SimpleLRU _storage;
+
+    Concurrency::FlatCombine<lru_op> _combiner;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FLAT_COMBINING_LRU_H
@@ -0,0 +1,256 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * 64 bit MurmurHash2 (MurmurHash64A) of the given byte string
+ */
+inline uint64_t hash_bytes(const char *data, std::size_t len) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = 0x9747b28c ^ (len * m);
+
+    const char *end = data + (len & ~std::size_t(7));
+    for (; data != end; data += 8) {
+        uint64_t k;
+        std::memcpy(&k, data, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    uint64_t tail = 0;
+    switch (len & 7) {
+    case 7:
+        tail ^= uint64_t(uint8_t(data[6])) << 48;
+    case 6:
+        tail ^= uint64_t(uint8_t(data[5])) << 40;
+    case 5:
+        tail ^= uint64_t(uint8_t(data[4])) << 32;
+    case 4:
+        tail ^= uint64_t(uint8_t(data[3])) << 24;
+    case 3:
+        tail ^= uint64_t(uint8_t(data[2])) << 16;
+    case 2:
+        tail ^= uint64_t(uint8_t(data[1])) << 8;
+    case 1:
+        tail ^= uint64_t(uint8_t(data[0]));
+        h ^= tail;
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+/**
+ * # Open addressing hash index
+ * Maps keys onto non-owned elements of type T using Robin Hood hashing with linear probing.
+ * All slots live in one flat array, each slot keeps 32 bit hash fingerprint next to the element
+ * pointer, so that most of probes are resolved without touching the key itself. Deletion uses
+ * backward shift, so there are no tombstones and lookups stay short under churn.
+ *
+ * KeyOf is a functor that returns key of the element, result must provide data() and size().
+ * Index doesn't own elements, caller is responsible to keep them alive while they are indexed.
+ *
+ * Slots array is allocated by Alloc rebound to the slot type. If allocation fails on growth then
+ * exception is propagated and index is left unchanged.
+ */
+template <typename T, typename KeyOf, typename Alloc = std::allocator<T *>> class HashIndex {
+public:
+    HashIndex(const Alloc &alloc = Alloc()) : _slots(slot_alloc(alloc)), _mask(0), _size(0) {}
+
+    inline std::size_t size() const { return _size; }
+
+    /**
+     * Returns element with the given key or nullptr if there is no such
+     */
+    T *find(const char *key, std::size_t len) const {
+        if (_size == 0) {
+            return nullptr;
+        }
+
+        uint32_t hash = _hash(key, len);
+        std::size_t pos = hash & _mask;
+        for (std::size_t dist = 0;; dist++, pos = (pos + 1) & _mask) {
+            const slot &s = _slots[pos];
+            // Robin Hood invariant: if key were here it would be placed before any element
+            // that is closer to its home slot than we are
+            if (s.value == nullptr || _distance(s.hash, pos) < dist) {
+                return nullptr;
+            }
+            if (s.hash == hash && _equals(*s.value, key, len)) {
+                return s.value;
+            }
+        }
+    }
+
+    T *find(const std::string &key) const { return find(key.data(), key.size()); }
+
+    /**
+     * Adds given element into index. Element with the same key must not be present
+     */
+    void insert(T *value) {
+        if ((_size + 1) * 8 > _slots.size() * 7) {
+            _grow();
+        }
+
+        auto key = KeyOf()(*value);
+        _place(slot{_hash(key.data(), key.size()), value});
+        _size++;
+    }
+
+    /**
+     * Removes element with the given key from the index, returns removed element or nullptr
+     * if there were no such key
+     */
+    T *erase(const char *key, std::size_t len) {
+        if (_size == 0) {
+            return nullptr;
+        }
+
+        uint32_t hash = _hash(key, len);
+        std::size_t pos = hash & _mask;
+        for (std::size_t dist = 0;; dist++, pos = (pos + 1) & _mask) {
+            slot &s = _slots[pos];
+            if (s.value == nullptr || _distance(s.hash, pos) < dist) {
+                return nullptr;
+            }
+            if (s.hash == hash && _equals(*s.value, key, len)) {
+                break;
+            }
+        }
+
+        T *result = _slots[pos].value;
+
+        // Backward shift: pull following elements one slot closer to their home until
+        // either empty slot or element that is already at home
+        std::size_t next = (pos + 1) & _mask;
+        while (_slots[next].value != nullptr && _distance(_slots[next].hash, next) > 0) {
+            _slots[pos] = _slots[next];
+            pos = next;
+            next = (next + 1) & _mask;
+        }
+        _slots[pos] = slot{0, nullptr};
+        _size--;
+        return result;
+    }
+
+    T *erase(const std::string &key) { return erase(key.data(), key.size()); }
+
+    /**
+     * Element has been moved in memory: replaces from with to keeping position in the index. Key of
+     * the element is read from its new location. Returns false if from isn't indexed
+     */
+    bool relocate(const T *from, T *to) {
+        if (_size == 0) {
+            return false;
+        }
+
+        auto key = KeyOf()(*to);
+        uint32_t hash = _hash(key.data(), key.size());
+        std::size_t pos = hash & _mask;
+        for (std::size_t dist = 0;; dist++, pos = (pos + 1) & _mask) {
+            slot &s = _slots[pos];
+            if (s.value == nullptr || _distance(s.hash, pos) < dist) {
+                return false;
+            }
+            if (s.value == from) {
+                s.value = to;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Removes all elements, memory is kept for further use
+     */
+    void clear() {
+        for (auto &s : _slots) {
+            s = slot{0, nullptr};
+        }
+        _size = 0;
+    }
+
+private:
+    struct slot {
+        // Fingerprint of the key, home slot is derived from it as well
+        uint32_t hash;
+
+        // Indexed element, nullptr marks empty slot
+        T *value;
+    };
+
+    using slot_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<slot>;
+
+    static uint32_t _hash(const char *key, std::size_t len) {
+        uint64_t h = hash_bytes(key, len);
+        return uint32_t(h >> 32) ^ uint32_t(h);
+    }
+
+    static bool _equals(const T &value, const char *key, std::size_t len) {
+        auto other = KeyOf()(value);
+        return other.size() == len && std::memcmp(other.data(), key, len) == 0;
+    }
+
+    // How far is the slot pos from home slot of the given hash
+    inline std::size_t _distance(uint32_t hash, std::size_t pos) const { return (pos - (hash & _mask)) & _mask; }
+
+    // Robin Hood insertion: element that is further from home takes the slot, poorer one continues probing
+    void _place(slot s) {
+        std::size_t pos = s.hash & _mask;
+        for (std::size_t dist = 0;; dist++, pos = (pos + 1) & _mask) {
+            slot &cur = _slots[pos];
+            if (cur.value == nullptr) {
+                cur = s;
+                return;
+            }
+
+            std::size_t cur_dist = _distance(cur.hash, pos);
+            if (cur_dist < dist) {
+                std::swap(cur, s);
+                dist = cur_dist;
+            }
+        }
+    }
+
+    void _grow() {
+        std::vector<slot, slot_alloc> old(_slots.size() == 0 ? 16 : _slots.size() * 2, slot{0, nullptr},
+                                          _slots.get_allocator());
+        old.swap(_slots);
+        _mask = _slots.size() - 1;
+
+        for (auto &s : old) {
+            if (s.value != nullptr) {
+                _place(s);
+            }
+        }
+    }
+
+    // Flat array of slots, size is always power of 2
+    std::vector<slot, slot_alloc> _slots;
+
+    // _slots.size() - 1
+    std::size_t _mask;
+
+    // Number of elements in the index
+    std::size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
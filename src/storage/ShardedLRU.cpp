@@ -0,0 +1,150 @@
+#include "ShardedLRU.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <stdexcept>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Memory of pools of heap based shards is mapped upfront, so it is kept within these bounds. Entries
+// pools have no room for are allocated on heap
+const size_t kMinPoolsArea = size_t(1) << 20;
+const size_t kMaxPoolsArea = size_t(64) << 20;
+
+} // namespace
+
+// See ShardedLRU.h
+ShardedLRU::ShardedLRU(size_t n_shards, size_t shard_max_size) {
+    if (n_shards == 0) {
+        throw std::invalid_argument("Number of shards must be positive");
+    }
+
+    // Node headers and rounding up to the class size take extra memory beyond keys and values
+    size_t area = std::min(std::max(2 * n_shards * shard_max_size, kMinPoolsArea), kMaxPoolsArea);
+    _arena = std::make_shared<Allocator::Arena>(area, false);
+    _pools = std::make_shared<Allocator::PoolSet>(_arena->base(), _arena->size());
+
+    _shards.reserve(n_shards);
+    for (size_t i = 0; i < n_shards; i++) {
+        _shards.emplace_back(new shard(shard_max_size, _pools));
+    }
+}
+
+// See ShardedLRU.h
+ShardedLRU::ShardedLRU(size_t n_shards, std::shared_ptr<Allocator::Arena> arena) : _arena(arena) {
+    if (n_shards == 0) {
+        throw std::invalid_argument("Number of shards must be positive");
+    }
+
+    // Keep slices 8 bytes aligned
+    size_t slice = (arena->size() / n_shards) & ~size_t(7);
+    char *base = static_cast<char *>(arena->base());
+    _shards.reserve(n_shards);
+    for (size_t i = 0; i < n_shards; i++) {
+        _shards.emplace_back(new shard(base + i * slice, slice));
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ShardedLRU::Put(const std::string &key, const std::string &value) {
+    shard &s = _shard_for(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    return s.storage.Put(key, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ShardedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    shard &s = _shard_for(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    return s.storage.PutIfAbsent(key, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ShardedLRU::Set(const std::string &key, const std::string &value) {
+    shard &s = _shard_for(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    return s.storage.Set(key, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ShardedLRU::Delete(const std::string &key) {
+    shard &s = _shard_for(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    return s.storage.Delete(key);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ShardedLRU::Get(const std::string &key, std::string &value) {
+    shard &s = _shard_for(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    return s.storage.Get(key, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ShardedLRU::Get(const std::string &key, Value &value) {
+    shard &s = _shard_for(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    return s.storage.Get(key, value);
+}
+
+// See ShardedLRU.h
+void ShardedLRU::GetStats(std::vector<std::pair<std::string, std::string>> &stats) {
+    // Shards report counters of the same names, sum them up. Values that are not numbers
+    // or not additive, like sizes of slab classes, are taken from the first shard reporting them
+    std::vector<std::pair<std::string, std::string>> total;
+    std::vector<uint64_t> sums;
+    std::map<std::string, size_t> positions;
+    for (auto &s : _shards) {
+        std::vector<std::pair<std::string, std::string>> shard_stats;
+        {
+            std::lock_guard<std::mutex> lock(s->lock);
+            s->storage.GetStats(shard_stats);
+        }
+
+        for (auto &stat : shard_stats) {
+            auto it = positions.find(stat.first);
+            if (it == positions.end()) {
+                it = positions.emplace(stat.first, total.size()).first;
+                total.push_back(std::make_pair(stat.first, std::string()));
+                sums.push_back(0);
+            }
+
+            size_t i = it->second;
+            const std::string &name = stat.first;
+            const std::string &v = stat.second;
+            bool additive = name != "slab_size" && name.find(":chunk_size") == std::string::npos;
+            if (additive && !v.empty() && v.find_first_not_of("0123456789") == std::string::npos) {
+                sums[i] += std::stoull(v);
+                total[i].second = std::to_string(sums[i]);
+            } else if (total[i].second.empty()) {
+                total[i].second = v;
+            }
+        }
+    }
+
+    stats.emplace_back("shards", std::to_string(_shards.size()));
+    if (_arena) {
+        stats.emplace_back("arena_bytes", std::to_string(_arena->size()));
+        stats.emplace_back("arena_pages", _arena->mode_name());
+    }
+    stats.insert(stats.end(), total.begin(), total.end());
+}
+
+// See ShardedLRU.h
+ShardedLRU::shard &ShardedLRU::_shard_for(const std::string &key) {
+    // std::hash could be an identity-like function with poor low bits, mix it a bit
+    // before taking modulo so that similar keys are spread evenly
+    uint64_t h = std::hash<std::string>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return *_shards[h % _shards.size()];
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,99 @@
+#ifndef AFINA_STORAGE_SHARDED_LRU_H
+#define AFINA_STORAGE_SHARDED_LRU_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/PoolSet.h>
+#include <afina/allocator/Simple.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Sharded LRU
+ * Thread safe storage that spreads keys across several independent SimpleLRU instances
+ * by key hash. Each shard has its own lock and its own byte budget, so operations on
+ * different shards never contend with each other.
+ *
+ * Note that LRU order is maintained per shard: eviction in one shard doesn't account
+ * for freshness of elements in the others.
+ */
+class ShardedLRU : public Afina::Storage {
+public:
+    /**
+     * Entries are allocated from size classed pools shared by all shards, so threads working with
+     * different shards don't contend on memory allocation either
+     *
+     * @param n_shards number of independent shards, must be greater than zero
+     * @param shard_max_size maximum number of bytes (keys+values) in each shard
+     */
+    ShardedLRU(size_t n_shards = 16, size_t shard_max_size = 1024);
+
+    /**
+     * Shards split the arena into equal parts, each one is managed by its own allocator and
+     * limited by its size only
+     *
+     * @param n_shards number of independent shards, must be greater than zero
+     * @param arena memory for all entries
+     */
+    ShardedLRU(size_t n_shards, std::shared_ptr<Allocator::Arena> arena);
+    ~ShardedLRU() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface
+    void GetStats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Single partition of the storage
+    struct shard {
+        shard(size_t max_size, std::shared_ptr<Allocator::PoolSet> pools) : storage(max_size, pools) {}
+        shard(char *base, size_t size) : allocator(new Allocator::Simple(base, size)), storage(size, *allocator) {}
+
+        // Memory of the shard if storage is backed by arena
+        std::unique_ptr<Allocator::Simple> allocator;
+
+        std::mutex lock;
+        SimpleLRU storage;
+    };
+
+    // Select shard responsible for the given key
+    shard &_shard_for(const std::string &key);
+
+    // Memory shared by all partitions: either entries themselves or pools for them
+    std::shared_ptr<Allocator::Arena> _arena;
+
+    // Pools over the arena if entries are heap based
+    std::shared_ptr<Allocator::PoolSet> _pools;
+
+    // All partitions, never changes after construction
+    std::vector<std::unique_ptr<shard>> _shards;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARDED_LRU_H
@@ -1,22 +1,431 @@
 #include "SimpleLRU.h"
 
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Simple.h>
+
 namespace Afina {
 namespace Backend {
 
+namespace {
+
+// Values starting from this size are shared with readers instead of being copied out
+const std::size_t kSharedValue = 1024;
+
+// Number of bytes allocator may move between two operations while compacting holes left by removed nodes
+const std::size_t kDefragBudget = 4096;
+
+} // namespace
+
+// See SimpleLRU.h
+SimpleLRU::SimpleLRU(size_t max_size, Allocator::Simple &allocator)
+    : _max_size(max_size), _cur_size(0), _evictions(0), _allocator(&allocator), _defrag_pending(false),
+      _lru_head(nullptr), _lru_tail(nullptr), _lru_index(Allocator::StlAdapter<lru_node *>(allocator)) {
+    _allocator->on_relocate([this](void *from, void *to) { _relocate(from, to); });
+}
+
+// See SimpleLRU.h
+SimpleLRU::SimpleLRU(std::shared_ptr<Allocator::Arena> arena)
+    : SimpleLRU(arena, std::unique_ptr<Allocator::Simple>(new Allocator::Simple(arena->base(), arena->size()))) {}
+
+// See SimpleLRU.h
+SimpleLRU::SimpleLRU(std::shared_ptr<Allocator::Arena> arena, std::unique_ptr<Allocator::Simple> allocator)
+    : SimpleLRU(arena->size(), *allocator) {
+    _own_allocator = std::move(allocator);
+    _arena = std::move(arena);
+}
+
+// See SimpleLRU.h
+SimpleLRU::SimpleLRU(size_t max_size, std::shared_ptr<Allocator::PoolSet> pools) : SimpleLRU(max_size) {
+    _pools = std::move(pools);
+}
+
+// See SimpleLRU.h
+SimpleLRU::~SimpleLRU() {
+    _lru_index.clear();
+
+    // Walk the list instead of recursion, so that huge caches don't blow up the stack
+    lru_node *node = _lru_head;
+    while (node != nullptr) {
+        lru_node *next = node->next;
+        _free_node(node, false);
+        node = next;
+    }
+
+    if (_allocator != nullptr) {
+        _allocator->on_relocate(nullptr);
+    }
+}
+
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) { return false; }
+bool SimpleLRU::Put(const std::string &key, const std::string &value) {
+    _defrag_step();
+
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    lru_node *node = _lru_index.find(key);
+    if (node != nullptr) {
+        return _update(*node, value);
+    }
+    return _insert(key, value);
+}
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) { return false; }
+bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    _defrag_step();
+
+    if (key.size() + value.size() > _max_size || _lru_index.find(key) != nullptr) {
+        return false;
+    }
+    return _insert(key, value);
+}
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) { return false; }
+bool SimpleLRU::Set(const std::string &key, const std::string &value) {
+    _defrag_step();
+
+    lru_node *node = _lru_index.find(key);
+    if (node == nullptr || key.size() + value.size() > _max_size) {
+        return false;
+    }
+    return _update(*node, value);
+}
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete(const std::string &key) { return false; }
+bool SimpleLRU::Delete(const std::string &key) {
+    _defrag_step();
+
+    lru_node *node = _lru_index.find(key);
+    if (node == nullptr) {
+        return false;
+    }
+    _remove(*node);
+    return true;
+}
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Get(const std::string &key, std::string &value) { return false; }
+bool SimpleLRU::Get(const std::string &key, std::string &value) {
+    lru_node *node = _lru_index.find(key);
+    if (node == nullptr) {
+        return false;
+    }
+
+    if (node != _lru_tail) {
+        _unlink(*node);
+        _link_tail(*node);
+    }
+    value.assign(node->value(), node->value_size);
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Get(const std::string &key, Value &value) {
+    lru_node *node = _lru_index.find(key);
+    if (node == nullptr) {
+        return false;
+    }
+
+    if (node != _lru_tail) {
+        _unlink(*node);
+        _link_tail(*node);
+    }
+    if (node->shared) {
+        value = node->shared;
+    } else {
+        value = std::make_shared<const std::string>(node->inline_value(), node->value_size);
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::GetStats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_lru_index.size()));
+    stats.emplace_back("bytes", std::to_string(_cur_size));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    if (_arena) {
+        stats.emplace_back("arena_bytes", std::to_string(_arena->size()));
+        stats.emplace_back("arena_pages", _arena->mode_name());
+    }
+    if (_allocator == nullptr) {
+        return;
+    }
+
+    // Per slab class stats, named the same way as memcached "stats slabs" does
+    stats.emplace_back("slab_size", std::to_string(_allocator->slab_size()));
+    int id = 0;
+    for (auto &s : _allocator->stats()) {
+        id++;
+        if (s.slabs == 0 && s.allocs == 0) {
+            continue;
+        }
+
+        std::string prefix = (s.chunk_size == 0) ? "large:" : std::to_string(id) + ":";
+        stats.emplace_back(prefix + "chunk_size", std::to_string(s.chunk_size));
+        stats.emplace_back(prefix + "total_pages", std::to_string(s.slabs));
+        stats.emplace_back(prefix + "used_chunks", std::to_string(s.used_chunks));
+        stats.emplace_back(prefix + "free_chunks", std::to_string(s.free_chunks));
+        stats.emplace_back(prefix + "evicted", std::to_string(s.evictions));
+        stats.emplace_back(prefix + "outofmemory", std::to_string(s.failures));
+    }
+}
+
+// See SimpleLRU.h
+SimpleLRU::lru_node *SimpleLRU::_alloc_node(std::size_t key_size, std::size_t value_size) {
+    std::size_t size = _node_size(key_size, value_size);
+
+    void *mem = nullptr;
+    Allocator::Pointer ptr;
+    if (_allocator == nullptr) {
+        if (_pools) {
+            mem = _pools->alloc(size);
+        }
+        if (mem == nullptr) {
+            mem = ::operator new(size);
+        }
+    } else {
+        std::size_t cls = _allocator->class_of(size);
+        bool compacted = false;
+
+        // Nodes between list head and cursor are known to be of other classes
+        bool scanning = false;
+        lru_node *cursor = nullptr;
+        for (;;) {
+            try {
+                ptr = _allocator->alloc(size);
+                break;
+            } catch (Allocator::AllocError &) {
+                // Holes in partially used slabs may add up to a whole free slab, that is cheaper
+                // than losing entries. Each attempt is bounded by a single slab worth of moves
+                if (!compacted) {
+                    compacted = true;
+                    _allocator->defrag_step(_allocator->slab_size());
+                    continue;
+                }
+                if (_lru_head == nullptr) {
+                    return nullptr;
+                }
+
+                // Chunk of the requested class is reused right away, while chunks of other classes
+                // help only once their whole slab gets empty. So least recently used node of the same
+                // class goes first, least recently used one overall only if class has none left
+                if (!scanning) {
+                    scanning = true;
+                    cursor = _lru_head;
+                }
+                while (cursor != nullptr && _allocator->class_of(cursor->mem) != cls) {
+                    cursor = cursor->next;
+                }
+
+                lru_node *victim = _lru_head;
+                if (cursor != nullptr) {
+                    victim = cursor;
+                    cursor = cursor->next;
+                }
+                _remove(*victim, true);
+            }
+        }
+        mem = ptr.get();
+    }
+
+    return new (mem) lru_node{nullptr, nullptr, key_size, value_size, ptr, nullptr};
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::_node_size(std::size_t key_size, std::size_t value_size) const {
+    return sizeof(lru_node) + key_size + (_is_shared(value_size) ? 0 : value_size);
+}
+
+// See SimpleLRU.h
+SimpleLRU::lru_node *SimpleLRU::_make_node(const std::string &key, const std::string &value) {
+    lru_node *node = _alloc_node(key.size(), value.size());
+    if (node != nullptr) {
+        std::memcpy(node->key(), key.data(), key.size());
+        _fill_value(*node, value);
+    }
+    return node;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::_is_shared(std::size_t value_size) const { return _allocator == nullptr && value_size >= kSharedValue; }
+
+// See SimpleLRU.h
+void SimpleLRU::_fill_value(lru_node &node, const std::string &value) {
+    // Blob could be in use by readers, so it is replaced rather than overwritten
+    if (_is_shared(value.size())) {
+        node.shared = std::make_shared<const std::string>(value);
+    } else {
+        std::memcpy(node.inline_value(), value.data(), value.size());
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::_relocate(void *from, void *to) {
+    lru_node *node = static_cast<lru_node *>(to);
+    if (node->prev != nullptr) {
+        node->prev->next = node;
+    } else if (_lru_head == from) {
+        _lru_head = node;
+    }
+
+    if (node->next != nullptr) {
+        node->next->prev = node;
+    } else if (_lru_tail == from) {
+        _lru_tail = node;
+    }
+
+    _lru_index.relocate(static_cast<lru_node *>(from), node);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::_free_node(lru_node *node, bool evicted) {
+    if (_allocator == nullptr) {
+        std::size_t size = _node_size(node->key_size, node->value_size);
+        node->~lru_node();
+        if (_pools && _pools->owns(node)) {
+            _pools->free(node, size);
+        } else {
+            ::operator delete(node);
+        }
+        return;
+    }
+
+    Allocator::Pointer ptr = node->mem;
+    node->~lru_node();
+    _defrag_pending = true;
+    if (evicted) {
+        _allocator->evict(ptr);
+    } else {
+        _allocator->free(ptr);
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::_defrag_step() {
+    if (_defrag_pending) {
+        _defrag_pending = _allocator->defrag_step(kDefragBudget);
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::_link_tail(lru_node &node) {
+    node.prev = _lru_tail;
+    node.next = nullptr;
+    if (_lru_tail == nullptr) {
+        _lru_head = &node;
+    } else {
+        _lru_tail->next = &node;
+    }
+    _lru_tail = &node;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::_unlink(lru_node &node) {
+    if (node.prev == nullptr) {
+        _lru_head = node.next;
+    } else {
+        node.prev->next = node.next;
+    }
+
+    if (node.next == nullptr) {
+        _lru_tail = node.prev;
+    } else {
+        node.next->prev = node.prev;
+    }
+    node.prev = node.next = nullptr;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::_remove(lru_node &node, bool evicted) {
+    _lru_index.erase(node.key(), node.key_size);
+    _cur_size -= node.key_size + node.value_size;
+    _unlink(node);
+    if (evicted) {
+        _evictions++;
+    }
+    _free_node(&node, evicted);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::_free_space(std::size_t need) {
+    while (_lru_head != nullptr && _max_size - _cur_size < need) {
+        _remove(*_lru_head, true);
+    }
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::_insert(const std::string &key, const std::string &value) {
+    _free_space(key.size() + value.size());
+    lru_node *node = _make_node(key, value);
+    if (node == nullptr) {
+        return false;
+    }
+    return _insert(node);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::_insert(lru_node *node) {
+    _link_tail(*node);
+    _cur_size += node->key_size + node->value_size;
+    for (;;) {
+        try {
+            _lru_index.insert(node);
+            return true;
+        } catch (std::bad_alloc &) {
+            // Index doesn't grow after removal of any entry, so this loop ends quickly
+            bool self = (_lru_head == node);
+            if (self) {
+                _unlink(*node);
+                _cur_size -= node->key_size + node->value_size;
+                _evictions++;
+                _free_node(node, true);
+                return false;
+            }
+            _remove(*_lru_head, true);
+        }
+    }
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::_update(lru_node &node, const std::string &value) {
+    // Same size value could be overwritten right in place
+    if (node.value_size == value.size()) {
+        _fill_value(node, value);
+        if (&node != _lru_tail) {
+            _unlink(node);
+            _link_tail(node);
+        }
+        return true;
+    }
+
+    // Otherwise key has to be moved into a new node of the proper size. Old one leaves the list
+    // first, so that eviction below never sees it, but stays alive as a source of the key
+    _unlink(node);
+    _cur_size -= node.key_size + node.value_size;
+    _free_space(node.key_size + value.size());
+
+    // Allocation could compact arena and move the old node, so it is re-read through its handle
+    Allocator::Pointer handle = node.mem;
+    lru_node *fresh = _alloc_node(node.key_size, value.size());
+    lru_node *old = (_allocator == nullptr) ? &node : static_cast<lru_node *>(handle.get());
+
+    _lru_index.erase(old->key(), old->key_size);
+    if (fresh != nullptr) {
+        std::memcpy(fresh->key(), old->key(), old->key_size);
+        _fill_value(*fresh, value);
+    }
+    _free_node(old, false);
+    if (fresh == nullptr) {
+        return false;
+    }
+
+    return _insert(fresh);
+}
 
 } // namespace Backend
 } // namespace Afina
@@ -1,28 +1,63 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
-#include <map>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <mutex>
 #include <string>
 
 #include <afina/Storage.h>
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/PoolSet.h>
+#include <afina/allocator/StlAdapter.h>
+
+#include "HashIndex.h"
 
 namespace Afina {
 namespace Backend {
 
 /**
- * # Map based implementation
+ * # Hash index based implementation
  * That is NOT thread safe implementaiton!!
+ *
+ * Large values of heap based cache are kept in shared immutable blobs, so Get could hand them out
+ * without copying. Evicted or replaced blob is freed once the last reader drops it
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size) {}
-
-    ~SimpleLRU() {
-        _lru_index.clear();
-        _lru_head.reset(); // TODO: Here is stack overflow
-    }
+    SimpleLRU(size_t max_size = 1024)
+        : _max_size(max_size), _cur_size(0), _evictions(0), _allocator(nullptr), _defrag_pending(false),
+          _lru_head(nullptr), _lru_tail(nullptr) {}
+
+    /**
+     * Cache that places all its entries into memory managed by the given allocator instead of heap. Once
+     * allocator runs out of memory least recently used entries are evicted, the same way as when max_size
+     * is reached. Index lives in the allocator as well. Before evicting anything cache gives allocator
+     * a chance to compact partially used slabs.
+     * Cache registers itself as the allocator relocation callback, so allocator must be used by one cache
+     * only and outlive it.
+     *
+     * @param max_size maximum number of bytes in keys and values
+     * @param allocator memory entries are allocated from
+     */
+    SimpleLRU(size_t max_size, Allocator::Simple &allocator);
+
+    /**
+     * Cache that takes the whole arena, see above. Allocator over the arena is owned by the cache
+     */
+    SimpleLRU(std::shared_ptr<Allocator::Arena> arena);
+
+    /**
+     * Heap based cache that takes nodes from the pools first, so that caches used by different threads
+     * don't contend on heap. Nodes pools have no room for are allocated on heap
+     *
+     * @param max_size maximum number of bytes in keys and values
+     * @param pools memory nodes are allocated from, could be shared with other caches
+     */
+    SimpleLRU(size_t max_size, std::shared_ptr<Allocator::PoolSet> pools);
+
+    ~SimpleLRU();
 
     // Implements Afina::Storage interface
     bool Put(const std::string &key, const std::string &value) override;
@@ -39,27 +74,143 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, Value &value) override;
+
+    // Implements Afina::Storage interface
+    void GetStats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
 private:
-    // LRU cache node
-    using lru_node = struct lru_node {
-        std::string key;
-        std::string value;
-        std::unique_ptr<lru_node> prev;
-        std::unique_ptr<lru_node> next;
+    // Cache over the arena, allocator is taken over once construction succeeds, so it is released
+    // by the caller if delegated constructor throws
+    SimpleLRU(std::shared_ptr<Allocator::Arena> arena, std::unique_ptr<Allocator::Simple> allocator);
+
+    // LRU cache node, intrusive member of the doubly linked list. Key and value bytes are
+    // stored right after the node header in the same allocation:
+    // [lru_node][key bytes][value bytes]
+    //
+    // Value bytes are missing if value is shared
+    struct lru_node {
+        lru_node *prev;
+        lru_node *next;
+        std::size_t key_size;
+        std::size_t value_size;
+
+        // Memory node occupies if it lives in allocator
+        Allocator::Pointer mem;
+
+        // Value if it is kept outside of the node
+        Value shared;
+
+        inline char *key() { return reinterpret_cast<char *>(this + 1); }
+        inline const char *key() const { return reinterpret_cast<const char *>(this + 1); }
+        inline char *inline_value() { return key() + key_size; }
+        inline const char *value() const { return shared ? shared->data() : key() + key_size; }
+    };
+
+    // Key of the node as seen by the index
+    struct lru_key_ref {
+        const char *_data;
+        std::size_t _size;
+
+        inline const char *data() const { return _data; }
+        inline std::size_t size() const { return _size; }
     };
 
+    // Extracts key of the node for the index
+    struct lru_key {
+        lru_key_ref operator()(const lru_node &node) const { return lru_key_ref{node.key(), node.key_size}; }
+    };
+
+    // Allocate new node for key and value of the given sizes, it isn't linked anywhere yet and its
+    // content is left uninitialized. If allocator runs out of memory then partially used slabs get
+    // compacted and after that least recently used nodes of the same slab class get evicted, nodes
+    // of other classes only if there are none. Returns nullptr if even empty cache has no space
+    // for the node
+    //
+    // Allocation may move other nodes, so any raw pointers into nodes must be re-read after it
+    lru_node *_alloc_node(std::size_t key_size, std::size_t value_size);
+
+    // Size of memory block of the node
+    std::size_t _node_size(std::size_t key_size, std::size_t value_size) const;
+
+    // Allocate and fill new node, see _alloc_node
+    lru_node *_make_node(const std::string &key, const std::string &value);
+
+    // Value of the given size is kept in shared blob rather than in node. Nodes of allocator based
+    // cache are limited by its memory, so they always keep values inline
+    bool _is_shared(std::size_t value_size) const;
+
+    // Copy value into the new node or its blob
+    void _fill_value(lru_node &node, const std::string &value);
+
+    // Allocator moved node from one place to another, fix all links to it
+    void _relocate(void *from, void *to);
+
+    // Release memory of unlinked node
+    void _free_node(lru_node *node, bool evicted);
+
+    // Move a few nodes out of sparsely used slabs if some nodes were released since allocator got
+    // compact, called before each modification so that holes don't pile up until allocation fails
+    void _defrag_step();
+
+    // Link node to the tail of the list, i.e mark it as most recently used
+    void _link_tail(lru_node &node);
+
+    // Exclude node from the list, node itself is untouched
+    void _unlink(lru_node &node);
+
+    // Remove node from both list and index and release its memory
+    void _remove(lru_node &node, bool evicted = false);
+
+    // Evict least recently used nodes until there are at least `need` bytes free
+    void _free_space(std::size_t need);
+
+    // Append new node to the tail of the list, returns false if there is no memory for it
+    bool _insert(const std::string &key, const std::string &value);
+
+    // Link node and add it to the index. If there is no memory for index growth then least
+    // recently used nodes are evicted, returns false if node itself had to be evicted
+    bool _insert(lru_node *node);
+
+    // Replace value of the existing node and mark it as most recently used. Returns false if there
+    // is no memory for the new value, node is removed in this case
+    bool _update(lru_node &node, const std::string &value);
+
     // Maximum number of bytes could be stored in this cache.
     // i.e all (keys+values) must be less the _max_size
     std::size_t _max_size;
 
+    // Number of bytes occupied by keys and values at the moment
+    std::size_t _cur_size;
+
+    // Number of entries removed to free space for others
+    uint64_t _evictions;
+
+    // Where nodes are allocated, heap is used if nullptr
+    Allocator::Simple *_allocator;
+
+    // Allocator may have slabs to compact, see _defrag_step
+    bool _defrag_pending;
+
+    // Pools heap based nodes are allocated from first, if any
+    std::shared_ptr<Allocator::PoolSet> _pools;
+
+    // Memory owned by the cache if it was created over arena
+    std::shared_ptr<Allocator::Arena> _arena;
+    std::unique_ptr<Allocator::Simple> _own_allocator;
+
     // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
     // element that wasn't used for longest time.
     //
     // List owns all nodes
-    std::unique_ptr<lru_node> _lru_head;
+    lru_node *_lru_head;
+
+    // Most recently used element
+    lru_node *_lru_tail;
 
     // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<std::reference_wrapper<std::string>, std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
+    HashIndex<lru_node, lru_key, Allocator::StlAdapter<lru_node *>> _lru_index;
 };
 
 } // namespace Backend
@@ -18,40 +18,54 @@ namespace Backend {
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
     ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ThreadSafeSimplLRU(std::shared_ptr<Allocator::Arena> arena) : SimpleLRU(arena) {}
     ~ThreadSafeSimplLRU() {}
 
     // see SimpleLRU.h
     bool Put(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
+        std::lock_guard<std::mutex> lock(_lock);
         return SimpleLRU::Put(key, value);
     }
 
     // see SimpleLRU.h
     bool PutIfAbsent(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
+        std::lock_guard<std::mutex> lock(_lock);
         return SimpleLRU::PutIfAbsent(key, value);
     }
 
     // see SimpleLRU.h
     bool Set(const std::string &key, const std::string &value) override {
-        // TODO: sinchronization
+        std::lock_guard<std::mutex> lock(_lock);
         return SimpleLRU::Set(key, value);
     }
 
     // see SimpleLRU.h
     bool Delete(const std::string &key) override {
-        // TODO: sinchronization
+        std::lock_guard<std::mutex> lock(_lock);
         return SimpleLRU::Delete(key);
     }
 
     // see SimpleLRU.h
     bool Get(const std::string &key, std::string &value) override {
-        // TODO: sinchronization
+        std::lock_guard<std::mutex> lock(_lock);
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    bool Get(const std::string &key, Value &value) override {
+        std::lock_guard<std::mutex> lock(_lock);
+        return SimpleLRU::Get(key, value);
+    }
+
+    // see SimpleLRU.h
+    void GetStats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::lock_guard<std::mutex> lock(_lock);
+        SimpleLRU::GetStats(stats);
+    }
+
 private:
-    // TODO: sinchronization primitives
+    // Global lock, SimpleLRU modifies list even on Get so there is no point in RW lock
+    std::mutex _lock;
 };
 
 } // namespace Backend
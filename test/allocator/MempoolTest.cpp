@@ -0,0 +1,143 @@
+#include "gtest/gtest.h"
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/PoolSet.h>
+#include <afina/allocator/SlabCache.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+alignas(8) static char area[1 << 20];
+
+TEST(MempoolTest, SlabCacheExhaust) {
+    SlabCache cache(area, sizeof(area), 4096);
+    EXPECT_EQ(cache.total(), sizeof(area) / 4096);
+
+    vector<void *> slabs;
+    for (void *s = cache.get(); s != nullptr; s = cache.get()) {
+        slabs.push_back(s);
+    }
+    EXPECT_EQ(slabs.size(), cache.total());
+    EXPECT_EQ(set<void *>(slabs.begin(), slabs.end()).size(), slabs.size());
+
+    cache.put(slabs.back());
+    EXPECT_EQ(cache.get(), slabs.back());
+    EXPECT_EQ(cache.used(), cache.total());
+}
+
+TEST(MempoolTest, AllocReuse) {
+    SlabCache cache(area, sizeof(area), 4096);
+    Mempool pool(cache, 100, 8);
+    EXPECT_EQ(pool.object_size(), 104);
+
+    Mempool::ThreadCache local(pool);
+    set<void *> objects;
+    for (size_t i = 0; i < 3 * pool.objects_per_slab(); i++) {
+        void *p = local.alloc();
+        ASSERT_NE(p, nullptr);
+        EXPECT_GE(static_cast<char *>(p), area);
+        EXPECT_LE(static_cast<char *>(p) + pool.object_size(), area + sizeof(area));
+        objects.insert(p);
+    }
+    EXPECT_EQ(objects.size(), 3 * pool.objects_per_slab());
+    EXPECT_EQ(pool.slabs(), 3);
+
+    // Released objects are served again without new slabs
+    for (void *p : objects) {
+        local.free(p);
+    }
+    for (size_t i = 0; i < objects.size(); i++) {
+        EXPECT_EQ(objects.count(local.alloc()), 1);
+    }
+    EXPECT_EQ(pool.slabs(), 3);
+}
+
+TEST(MempoolTest, AllocNoMem) {
+    SlabCache cache(area, 8192, 4096);
+    Mempool pool(cache, 1000);
+    Mempool::ThreadCache local(pool);
+
+    for (size_t i = 0; i < 2 * pool.objects_per_slab(); i++) {
+        EXPECT_NE(local.alloc(), nullptr);
+    }
+    EXPECT_EQ(local.alloc(), nullptr);
+}
+
+TEST(MempoolTest, ConcurrentAllocFree) {
+    SlabCache cache(area, sizeof(area), 4096);
+    Mempool pool(cache, 64, 16);
+
+    // Threads churn through the pool at once, each object is marked by its owner so that
+    // handing out the same object twice is detected
+    const size_t threads = 4, rounds = 200, batch = 100;
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            Mempool::ThreadCache local(pool);
+            for (size_t r = 0; r < rounds; r++) {
+                vector<void *> mine;
+                for (size_t i = 0; i < batch; i++) {
+                    void *p = local.alloc();
+                    ASSERT_NE(p, nullptr);
+                    memset(p, int(t), pool.object_size());
+                    mine.push_back(p);
+                }
+                for (void *p : mine) {
+                    for (size_t i = 0; i < pool.object_size(); i++) {
+                        ASSERT_EQ(static_cast<char *>(p)[i], char(t));
+                    }
+                    local.free(p);
+                }
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    // All objects went back to the depot, so there is exactly objects_per_slab * slabs of them
+    Mempool::ThreadCache local(pool);
+    set<void *> objects;
+    for (void *p = local.alloc(); p != nullptr; p = local.alloc()) {
+        EXPECT_TRUE(objects.insert(p).second);
+    }
+    EXPECT_EQ(objects.size(), pool.objects_per_slab() * cache.total());
+}
+
+TEST(MempoolTest, PoolSetClasses) {
+    PoolSet pools(area, sizeof(area), 1024, 4096);
+    EXPECT_EQ(pools.max_object(), 1024);
+
+    // Blocks of different classes don't overlap
+    vector<pair<char *, size_t>> blocks;
+    for (size_t size : {1, 64, 65, 200, 1000, 1024}) {
+        char *p = static_cast<char *>(pools.alloc(size));
+        ASSERT_NE(p, nullptr);
+        EXPECT_TRUE(pools.owns(p));
+        memset(p, 'x', size);
+        blocks.emplace_back(p, size);
+    }
+    EXPECT_EQ(pools.alloc(1025), nullptr);
+
+    int local = 0;
+    EXPECT_FALSE(pools.owns(&local));
+
+    // Block freed by another thread is served again
+    thread other([&]() { pools.free(blocks[3].first, blocks[3].second); });
+    other.join();
+    set<void *> served;
+    for (size_t i = 0; i < 64; i++) {
+        served.insert(pools.alloc(blocks[3].second));
+    }
+    EXPECT_EQ(served.count(blocks[3].first), 1);
+
+    for (auto &b : blocks) {
+        if (b != blocks[3]) {
+            pools.free(b.first, b.second);
+        }
+    }
+}
@@ -1,11 +1,16 @@
 #include "gtest/gtest.h"
+#include <cstring>
 #include <iostream>
+#include <map>
 #include <set>
+#include <string>
 #include <vector>
 
+#include <afina/allocator/Arena.h>
 #include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 #include <afina/allocator/Simple.h>
+#include <afina/allocator/StlAdapter.h>
 
 using namespace std;
 using namespace Afina::Allocator;
@@ -322,3 +327,80 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, PinnedNotMoved) {
+    Simple a(buf, sizeof(buf), 512);
+
+    // Two slabs of four chunks: the first one keeps only pinned block, the second one has a
+    // hole. Compaction would evacuate the first slab if block there wasn't pinned
+    void *pinned = a.alloc_pinned(100);
+    memset(pinned, 'p', 100);
+
+    vector<Pointer> ptrs;
+    for (int i = 0; i < 7; i++) {
+        ptrs.push_back(a.alloc(100));
+    }
+    a.free(ptrs[0]);
+    a.free(ptrs[1]);
+    a.free(ptrs[2]);
+    a.free(ptrs[3]);
+
+    a.defrag();
+    EXPECT_EQ(string(static_cast<char *>(pinned), 100), string(100, 'p'));
+    EXPECT_NO_THROW(a.free_pinned(pinned));
+
+    EXPECT_THROW(a.free_pinned(pinned), AllocError);
+    EXPECT_THROW(a.free_pinned(buf + 1), AllocError);
+}
+
+TEST(SimpleTest, StlContainers) {
+    Simple a(buf, sizeof(buf));
+
+    using arena_string = basic_string<char, char_traits<char>, StlAdapter<char>>;
+    using arena_map = map<int, arena_string, less<int>, StlAdapter<pair<const int, arena_string>>>;
+
+    StlAdapter<char> alloc(a);
+    vector<arena_string, StlAdapter<arena_string>> strings(alloc);
+    arena_map m(alloc);
+    for (int i = 0; i < 100; i++) {
+        strings.emplace_back(string(50, 'a' + i % 26).c_str(), alloc);
+        m.emplace(i, arena_string(to_string(i).c_str(), alloc));
+    }
+
+    for (auto &s : strings) {
+        EXPECT_GE(s.data(), buf);
+        EXPECT_LT(s.data(), buf + sizeof(buf));
+    }
+    EXPECT_EQ(m.size(), 100);
+    EXPECT_TRUE(m[42] == "42");
+
+    // Defragmentation never touches containers memory
+    const char *first = strings[0].data();
+    a.defrag();
+    EXPECT_EQ(first, strings[0].data());
+
+    // Area exhaustion is reported the standard way
+    vector<char, StlAdapter<char>> huge(alloc);
+    EXPECT_THROW(huge.resize(2 * sizeof(buf)), std::bad_alloc);
+
+    // Heap is used when no area is given
+    vector<int, StlAdapter<int>> heap;
+    heap.resize(10000);
+    EXPECT_FALSE(StlAdapter<int>() == alloc);
+}
+
+TEST(SimpleTest, ArenaBacked) {
+    Arena arena(4 << 20, true);
+    EXPECT_GE(arena.size(), 4 << 20);
+    EXPECT_NE(arena.mode_name(), nullptr);
+
+    Simple a(arena.base(), arena.size());
+    vector<Pointer> ptrs;
+    for (int i = 0; i < 3000; i++) {
+        ptrs.push_back(a.alloc(1000));
+        writeTo(ptrs.back(), 1000);
+    }
+    for (Pointer &p : ptrs) {
+        EXPECT_TRUE(isDataOk(p, 1000));
+    }
+}
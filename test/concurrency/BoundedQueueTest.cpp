@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/BoundedQueue.h>
+
+using namespace Afina::Concurrency;
+
+TEST(BoundedQueueTest, FifoAndBounds) {
+    BoundedQueue<int> queue(5);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(8));
+
+    int item;
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 8; i++) {
+            EXPECT_TRUE(queue.pop(item));
+            EXPECT_EQ(item, lap * 8 + i);
+            EXPECT_TRUE(queue.push((lap + 1) * 8 + i));
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(queue.pop(item));
+    }
+    EXPECT_FALSE(queue.pop(item));
+}
+
+TEST(BoundedQueueTest, ManyProducersOneConsumer) {
+    const int n_producers = 4, per_producer = 20000;
+    BoundedQueue<int> queue(64);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < n_producers; p++) {
+        producers.emplace_back([&queue, p, per_producer]() {
+            for (int i = 0; i < per_producer; i++) {
+                while (!queue.push(p * per_producer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Items of each producer come in its order and none is lost
+    std::vector<int> next(n_producers, 0);
+    int item;
+    for (int taken = 0; taken < n_producers * per_producer;) {
+        if (queue.pop(item)) {
+            int p = item / per_producer;
+            EXPECT_EQ(item % per_producer, next[p]);
+            next[p]++;
+            taken++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    EXPECT_FALSE(queue.pop(item));
+}
@@ -0,0 +1,50 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/CoreLocal.h>
+
+using namespace Afina::Concurrency;
+
+TEST(CoreLocalTest, SlotsArePadded) {
+    CoreLocal<std::atomic<uint64_t>> counters(4);
+    EXPECT_EQ(counters.size(), 4);
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(&counters[i]) % 64, 0);
+        EXPECT_EQ(counters[i].load(), 0);
+    }
+}
+
+TEST(CoreLocalTest, LineSizedValueTakesOneLine) {
+    struct line {
+        char bytes[64];
+    };
+    CoreLocal<line> lines(2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&lines[1]) - reinterpret_cast<uintptr_t>(&lines[0]), 64);
+}
+
+TEST(CoreLocalTest, ConcurrentIncrements) {
+    const int n_threads = 8, per_thread = 100000;
+    CoreLocal<std::atomic<uint64_t>> counters;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&counters, per_thread]() {
+            for (int i = 0; i < per_thread; i++) {
+                counters.local().fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    // Threads migrate between cores, but no update is lost
+    uint64_t sum = 0;
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        sum += counters[i].load();
+    }
+    EXPECT_EQ(sum, uint64_t(n_threads) * per_thread);
+}
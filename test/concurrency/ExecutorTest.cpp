@@ -0,0 +1,215 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+#include <afina/concurrency/WorkStealingDeque.h>
+
+using namespace Afina::Concurrency;
+
+TEST(WorkStealingDequeTest, OwnerLifo) {
+    WorkStealingDeque<int *> deque(2);
+    std::vector<int> items(100);
+    for (auto &i : items) {
+        deque.push(&i);
+    }
+
+    int *item;
+    EXPECT_TRUE(deque.steal(item));
+    EXPECT_EQ(item, &items[0]);
+    for (size_t i = items.size() - 1; i > 0; i--) {
+        EXPECT_TRUE(deque.pop(item));
+        EXPECT_EQ(item, &items[i]);
+    }
+    EXPECT_FALSE(deque.pop(item));
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDequeTest, ConcurrentSteal) {
+    const int count = 100000;
+    std::vector<int> items(count);
+    std::vector<std::atomic<int>> taken(count);
+    for (auto &t : taken) {
+        t.store(0);
+    }
+
+    WorkStealingDeque<int *> deque;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; t++) {
+        thieves.emplace_back([&]() {
+            int *item;
+            while (!done.load() || !deque.empty()) {
+                if (deque.steal(item)) {
+                    taken[item - items.data()]++;
+                }
+            }
+        });
+    }
+
+    // Owner mixes pushes and pops while thieves are at work
+    int *item;
+    for (int i = 0; i < count; i++) {
+        deque.push(&items[i]);
+        if (i % 3 == 0 && deque.pop(item)) {
+            taken[item - items.data()]++;
+        }
+    }
+    while (deque.pop(item)) {
+        taken[item - items.data()]++;
+    }
+    done.store(true);
+    for (auto &t : thieves) {
+        t.join();
+    }
+
+    // Every item is taken exactly once
+    for (auto &t : taken) {
+        EXPECT_EQ(t.load(), 1);
+    }
+}
+
+TEST(ExecutorTest, RunsAllTasks) {
+    std::atomic<int> counter(0);
+    {
+        Executor executor("test", 4);
+        for (int i = 0; i < 10000; i++) {
+            EXPECT_TRUE(executor.Execute([&counter]() { counter++; }));
+        }
+        executor.Stop(true);
+        EXPECT_EQ(executor.GetState(), Executor::State::kStopped);
+        EXPECT_FALSE(executor.Execute([&counter]() { counter++; }));
+    }
+    EXPECT_EQ(counter.load(), 10000);
+}
+
+TEST(ExecutorTest, NestedSubmit) {
+    std::atomic<int> counter(0);
+    Executor executor("test", 4);
+
+    // Tasks spawned from the pool go to the local deques and get stolen by idle threads
+    std::function<void(int)> fork = [&](int depth) {
+        counter++;
+        if (depth > 0) {
+            executor.Execute(fork, depth - 1);
+            executor.Execute(fork, depth - 1);
+        }
+    };
+    EXPECT_TRUE(executor.Execute(fork, 12));
+
+    for (int i = 0; i < 500 && counter.load() < (1 << 13) - 1; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    executor.Stop(true);
+    EXPECT_EQ(counter.load(), (1 << 13) - 1);
+}
+
+TEST(ExecutorTest, GrowAndShrink) {
+    Executor executor("test", 1, 4, std::chrono::milliseconds(50));
+    EXPECT_EQ(executor.Threads(), 1);
+
+    // Blocked tasks make pool add threads
+    std::atomic<bool> release(false);
+    std::atomic<int> running(0);
+    for (int i = 0; i < 4; i++) {
+        executor.Execute([&]() {
+            running++;
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+    for (int i = 0; i < 500 && running.load() < 4; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(running.load(), 4);
+    EXPECT_EQ(executor.Threads(), 4);
+
+    // Idle threads above minimum leave after timeout
+    release.store(true);
+    for (int i = 0; i < 500 && executor.Threads() > 1; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(executor.Threads(), 1);
+}
+
+// Occupies the only pool thread until released
+struct Blocker {
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+
+    void Run() {
+        started.store(true);
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void AwaitStart() {
+        while (!started.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+TEST(ExecutorTest, BoundedReject) {
+    Blocker blocker;
+    Executor executor("test", 1, 1, std::chrono::milliseconds(1000), 2, Executor::RejectPolicy::kReject);
+    EXPECT_TRUE(executor.Execute(&Blocker::Run, &blocker));
+    blocker.AwaitStart();
+
+    std::atomic<int> counter(0);
+    EXPECT_TRUE(executor.Execute([&counter]() { counter++; }));
+    EXPECT_TRUE(executor.Execute([&counter]() { counter++; }));
+    EXPECT_FALSE(executor.Execute([&counter]() { counter++; }));
+
+    auto stats = executor.GetStats();
+    EXPECT_EQ(stats.queued, 3);
+    EXPECT_EQ(stats.rejected, 1);
+    EXPECT_EQ(stats.in_queue, 2);
+
+    blocker.release.store(true);
+    executor.Stop(true);
+    EXPECT_EQ(counter.load(), 2);
+    EXPECT_EQ(executor.GetStats().in_queue, 0);
+}
+
+TEST(ExecutorTest, BoundedCallerRuns) {
+    Blocker blocker;
+    Executor executor("test", 1, 1, std::chrono::milliseconds(1000), 1, Executor::RejectPolicy::kCallerRuns);
+    EXPECT_TRUE(executor.Execute(&Blocker::Run, &blocker));
+    blocker.AwaitStart();
+
+    std::thread::id runner;
+    EXPECT_TRUE(executor.Execute([]() {}));
+    EXPECT_TRUE(executor.Execute([&runner]() { runner = std::this_thread::get_id(); }));
+    EXPECT_EQ(runner, std::this_thread::get_id());
+    EXPECT_EQ(executor.GetStats().caller_runs, 1);
+
+    blocker.release.store(true);
+}
+
+TEST(ExecutorTest, BoundedBlock) {
+    Blocker blocker;
+    Executor executor("test", 1, 1, std::chrono::milliseconds(1000), 1, Executor::RejectPolicy::kBlock,
+                      std::chrono::milliseconds(50));
+    EXPECT_TRUE(executor.Execute(&Blocker::Run, &blocker));
+    blocker.AwaitStart();
+    EXPECT_TRUE(executor.Execute([]() {}));
+
+    // Queue stays full, so submit gives up after timeout
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(executor.Execute([]() {}));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+
+    // Space appears while submitter waits
+    std::thread releaser([&blocker]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        blocker.release.store(true);
+    });
+    EXPECT_TRUE(executor.Execute([]() {}));
+    releaser.join();
+    EXPECT_EQ(executor.GetStats().rejected, 1);
+}
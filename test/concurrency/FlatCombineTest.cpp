@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/FlatCombine.h>
+
+using namespace Afina::Concurrency;
+
+struct AddOp {
+    int delta;
+    long result;
+};
+
+TEST(FlatCombineTest, AppliesEveryOperationOnce) {
+    const int n_threads = 8, per_thread = 20000;
+
+    // Counter and flag are touched only from apply function
+    long counter = 0;
+    bool in_apply = false;
+    FlatCombine<AddOp> combiner(
+        [&](AddOp &op) {
+            EXPECT_FALSE(in_apply);
+            in_apply = true;
+            counter += op.delta;
+            op.result = counter;
+            in_apply = false;
+        },
+        4);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&combiner, per_thread]() {
+            long last = 0;
+            for (int i = 0; i < per_thread; i++) {
+                AddOp op{1, 0};
+                combiner.Execute(op);
+
+                // Results seen by one thread grow since its operations are serialized
+                EXPECT_GT(op.result, last);
+                last = op.result;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(counter, long(n_threads) * per_thread);
+}
+
+TEST(FlatCombineTest, ExceptionGoesToOwner) {
+    const int n_threads = 4, per_thread = 5000;
+
+    // Odd deltas fail, the rest of operations must not notice
+    long counter = 0;
+    FlatCombine<AddOp> combiner(
+        [&](AddOp &op) {
+            if (op.delta % 2 != 0) {
+                throw std::runtime_error("odd");
+            }
+            counter += op.delta;
+            op.result = counter;
+        },
+        2);
+
+    std::atomic<long> failed(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&combiner, &failed, t, per_thread]() {
+            for (int i = 0; i < per_thread; i++) {
+                AddOp op{(t + i) % 2 == 0 ? 2 : 1, 0};
+                try {
+                    combiner.Execute(op);
+                    EXPECT_EQ(op.delta, 2);
+                } catch (std::runtime_error &) {
+                    EXPECT_EQ(op.delta, 1);
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(failed.load(), long(n_threads) * per_thread / 2);
+    EXPECT_EQ(counter, long(n_threads) * per_thread);
+}
@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+using namespace Afina::Concurrency;
+
+TEST(ThreadLocalTest, ValuePerThread) {
+    ThreadLocal<int> local;
+    local.get() = 1;
+
+    std::thread other([&local]() {
+        EXPECT_EQ(local.get(), 0);
+        local.get() = 2;
+        EXPECT_EQ(*local, 2);
+    });
+    other.join();
+    EXPECT_EQ(local.get(), 1);
+
+    // Value of the exited thread is gone
+    int count = 0;
+    local.for_each([&count](int &) { count++; });
+    EXPECT_EQ(count, 1);
+}
+
+TEST(ThreadLocalTest, AggregateLiveAndExited) {
+    const int n_threads = 8, per_thread = 10000;
+
+    uint64_t retired = 0;
+    ThreadLocal<std::atomic<uint64_t>> counters([&retired](std::atomic<uint64_t> &value) { retired += value.load(); });
+
+    // Half of threads stay alive until values are summed
+    std::atomic<int> done(0);
+    std::atomic<bool> release(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < per_thread; i++) {
+                counters->fetch_add(1, std::memory_order_relaxed);
+            }
+            done++;
+            while (t % 2 == 0 && !release.load()) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    while (done.load() < n_threads) {
+        std::this_thread::yield();
+    }
+    for (int t = 1; t < n_threads; t += 2) {
+        threads[t].join();
+    }
+
+    uint64_t live = 0;
+    int live_threads = 0;
+    counters.for_each([&](std::atomic<uint64_t> &value) {
+        live += value.load();
+        live_threads++;
+    });
+    EXPECT_EQ(live_threads, n_threads / 2);
+    EXPECT_EQ(live + retired, uint64_t(n_threads) * per_thread);
+
+    release.store(true);
+    for (int t = 0; t < n_threads; t += 2) {
+        threads[t].join();
+    }
+    EXPECT_EQ(retired, uint64_t(n_threads) * per_thread);
+}
+
+TEST(ThreadLocalTest, OutlivedByThread) {
+    std::atomic<bool> created(false), destroyed(false);
+    std::unique_ptr<ThreadLocal<int>> local(new ThreadLocal<int>());
+
+    std::thread other([&]() {
+        local->get() = 42;
+        created.store(true);
+        while (!destroyed.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!created.load()) {
+        std::this_thread::yield();
+    }
+
+    // Thread exit must not touch values destroyed together with ThreadLocal
+    local.reset();
+    destroyed.store(true);
+    other.join();
+
+    // New instance doesn't see stale value
+    ThreadLocal<int> fresh;
+    EXPECT_EQ(fresh.get(), 0);
+}
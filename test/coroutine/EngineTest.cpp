@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include <afina/coroutine/Engine.h>
 
@@ -37,9 +38,8 @@ void printb(Afina::Coroutine::Engine &pe, std::stringstream &out, void *&other)
     out << "B3 ";
 }
 
-std::stringstream out;
-void *pa = nullptr, *pb = nullptr;
-void _printer(Afina::Coroutine::Engine &pe, std::string &result) {
+// Stream and handles live in the test body, out of the stack region saved and restored by the engine
+void _printer(Afina::Coroutine::Engine &pe, std::stringstream &out, void *&pa, void *&pb, std::string &result) {
     // Create routines, note it doens't get control yet
     pa = pe.run(printa, pe, out, pb);
     pb = pe.run(printb, pe, out, pa);
@@ -58,7 +58,165 @@ void _printer(Afina::Coroutine::Engine &pe, std::string &result) {
 TEST(CoroutineTest, Printer) {
     Afina::Coroutine::Engine engine;
 
+    std::stringstream out;
+    void *pa = nullptr, *pb = nullptr;
     std::string result;
-    engine.start(_printer, engine, result);
+    engine.start(_printer, engine, out, pa, pb, result);
     ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
 }
+
+void _no_unblocker(Afina::Coroutine::Engine &) {}
+
+TEST(CoroutineTest, FixedStackStart) {
+    Afina::Coroutine::Engine engine(_no_unblocker,
+                                    Afina::Coroutine::Engine::StackMode::FixedStack);
+
+    int result;
+    engine.start(_calculator_add, result, 1, 2);
+
+    ASSERT_EQ(3, result);
+}
+
+TEST(CoroutineTest, FixedStackPrinter) {
+    Afina::Coroutine::Engine engine(_no_unblocker,
+                                    Afina::Coroutine::Engine::StackMode::FixedStack);
+
+    std::stringstream out;
+    void *pa = nullptr, *pb = nullptr;
+    std::string result;
+    engine.start(_printer, engine, out, pa, pb, result);
+    ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
+}
+
+void _yielder(Afina::Coroutine::Engine &pe, std::string &trace, char id) {
+    for (int i = 0; i < 3; i++) {
+        trace += id;
+        pe.yield();
+    }
+}
+
+void _yielders(Afina::Coroutine::Engine &pe, std::string &trace) {
+    pe.run(_yielder, pe, trace, 'a');
+    pe.run(_yielder, pe, trace, 'b');
+    pe.run(_yielder, pe, trace, 'c');
+}
+
+void _yield_round_robin(Afina::Coroutine::Engine::StackMode mode) {
+    Afina::Coroutine::Engine engine(_no_unblocker, mode);
+
+    // Each routine gets its turn, newest routines are at the head of the list
+    std::string trace;
+    engine.start(_yielders, engine, trace);
+    EXPECT_EQ(trace, "cbacbacba");
+}
+
+TEST(CoroutineTest, YieldRoundRobin) { _yield_round_robin(Afina::Coroutine::Engine::StackMode::StackCopy); }
+
+TEST(CoroutineTest, FixedStackYieldRoundRobin) {
+    _yield_round_robin(Afina::Coroutine::Engine::StackMode::FixedStack);
+}
+
+// Worker sleeps after each step until unblocker wakes it up
+void _sleeper(Afina::Coroutine::Engine &pe, std::vector<void *> &sleeping, int &counter, void *&self) {
+    for (int i = 0; i < 10; i++) {
+        counter++;
+        sleeping.push_back(self);
+        pe.block();
+    }
+}
+
+void _spawner(Afina::Coroutine::Engine &pe, std::vector<void *> &sleeping, int &counter, std::vector<void *> &handles) {
+    for (auto &handle : handles) {
+        handle = pe.run(_sleeper, pe, sleeping, counter, handle);
+        ASSERT_NE(handle, nullptr);
+    }
+}
+
+void _block_unblock(Afina::Coroutine::Engine::StackMode mode) {
+    // Unblocker plays role of event loop: it is called once everybody is blocked and wakes them all
+    std::vector<void *> sleeping;
+    int wakeups = 0;
+    Afina::Coroutine::Engine engine(
+        [&sleeping, &wakeups](Afina::Coroutine::Engine &pe) {
+            wakeups++;
+            for (void *routine : sleeping) {
+                pe.unblock(routine);
+            }
+            sleeping.clear();
+        },
+        mode);
+
+    int counter = 0;
+    std::vector<void *> handles(1000);
+    engine.start(_spawner, engine, sleeping, counter, handles);
+    EXPECT_EQ(counter, 10000);
+    EXPECT_EQ(wakeups, 11);
+}
+
+TEST(CoroutineTest, BlockUnblock) { _block_unblock(Afina::Coroutine::Engine::StackMode::StackCopy); }
+
+TEST(CoroutineTest, FixedStackBlockUnblock) { _block_unblock(Afina::Coroutine::Engine::StackMode::FixedStack); }
+
+int _deep(int depth) {
+    volatile char frame[512];
+    frame[0] = char(depth);
+    return depth == 0 ? frame[0] : _deep(depth - 1) + frame[0];
+}
+
+void _recurse(int &result, int depth) { result = _deep(depth); }
+
+TEST(CoroutineTest, FixedStackSize) {
+    // 1000 frames of more than 512 bytes don't fit default stack, but fit the bigger one
+    Afina::Coroutine::Engine engine(_no_unblocker,
+                                    Afina::Coroutine::Engine::StackMode::FixedStack, 1024 * 1024);
+
+    int result = 0;
+    engine.start(_recurse, result, 1000);
+    EXPECT_EQ(result, _deep(1000));
+}
+
+TEST(CoroutineTest, FixedStackGuard) {
+    // Overflow hits guard page instead of memory below the stack
+    Afina::Coroutine::Engine engine(_no_unblocker,
+                                    Afina::Coroutine::Engine::StackMode::FixedStack);
+
+    int result = 0;
+    EXPECT_DEATH(engine.start(_recurse, result, 1000), "");
+}
+
+void _child(int &counter) { counter++; }
+
+void _sequential(Afina::Coroutine::Engine &pe, int &counter) {
+    // Each child finishes before the next one starts, so they all run on the same recycled context
+    for (int i = 0; i < 100; i++) {
+        pe.sched(pe.run(_child, counter));
+    }
+
+    // Children started at once need own contexts
+    for (int i = 0; i < 10; i++) {
+        pe.run(_child, counter);
+    }
+    while (counter < 110) {
+        pe.yield();
+    }
+}
+
+void _pool_reuse(Afina::Coroutine::Engine::StackMode mode) {
+    Afina::Coroutine::Engine engine(_no_unblocker, mode, Afina::Coroutine::Engine::kDefaultStackSize, 4);
+
+    int counter = 0;
+    engine.start(_sequential, engine, counter);
+    EXPECT_EQ(counter, 110);
+
+    auto stats = engine.GetStats();
+    EXPECT_EQ(stats.created, 11);
+    EXPECT_EQ(stats.reused, 100);
+    EXPECT_EQ(stats.in_use, 0);
+    EXPECT_EQ(stats.in_use_max, 11);
+    EXPECT_EQ(stats.pooled, 4);
+    EXPECT_EQ(stats.pooled_max, 4);
+}
+
+TEST(CoroutineTest, PoolReuse) { _pool_reuse(Afina::Coroutine::Engine::StackMode::StackCopy); }
+
+TEST(CoroutineTest, FixedStackPoolReuse) { _pool_reuse(Afina::Coroutine::Engine::StackMode::FixedStack); }
@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Epoll.h>
+
+using namespace Afina::Coroutine;
+
+void _writer(Engine &engine, Epoll &io, int fd, std::string &data) {
+    EXPECT_EQ(io.co_write(engine, fd, data.data(), data.size()), ssize_t(data.size()));
+    io.co_close(fd);
+}
+
+void _reader(Engine &engine, Epoll &io, int fd, std::string &data) {
+    char buffer[4096];
+    ssize_t n;
+    while ((n = io.co_read(engine, fd, buffer, sizeof(buffer))) > 0) {
+        data.append(buffer, n);
+    }
+    EXPECT_EQ(n, 0);
+    io.co_close(fd);
+}
+
+void _pipe(Engine &engine, Epoll &io, int read_fd, int write_fd, std::string &in, std::string &out) {
+    engine.run(_reader, engine, io, std::move(read_fd), out);
+    engine.run(_writer, engine, io, std::move(write_fd), in);
+}
+
+TEST(EpollTest, ReadWrite) {
+    // Much more data than socket buffers hold, so both sides block many times
+    std::string in(8 * 1024 * 1024, 0), out;
+    for (size_t i = 0; i < in.size(); i++) {
+        in[i] = char(i * 7 + i / 4096);
+    }
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    Epoll io;
+    Engine engine([&io](Engine &pe) { io.Poll(pe); }, Engine::StackMode::FixedStack);
+    engine.start(_pipe, engine, io, std::move(fds[0]), std::move(fds[1]), in, out);
+
+    EXPECT_EQ(io.Waiting(), 0);
+    EXPECT_TRUE(in == out);
+}
+
+void _echo(Engine &engine, Epoll &io, int client) {
+    char buffer[256];
+    ssize_t n;
+    while ((n = io.co_read(engine, client, buffer, sizeof(buffer))) > 0) {
+        io.co_write(engine, client, buffer, n);
+    }
+    io.co_close(client);
+}
+
+void _acceptor(Engine &engine, Epoll &io, int server, int clients) {
+    for (int i = 0; i < clients; i++) {
+        int client = io.co_accept(engine, server, nullptr, nullptr);
+        ASSERT_GE(client, 0);
+        engine.run(_echo, engine, io, std::move(client));
+    }
+}
+
+TEST(EpollTest, Accept) {
+    int server = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    ASSERT_GE(server, 0);
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(server, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(server, 16), 0);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(getsockname(server, (struct sockaddr *)&addr, &len), 0);
+
+    // Blocking clients in other threads talk to coroutines served by one thread
+    const int n_clients = 8;
+    std::vector<std::thread> clients;
+    for (int i = 0; i < n_clients; i++) {
+        clients.emplace_back([addr, i]() {
+            int s = socket(AF_INET, SOCK_STREAM, 0);
+            ASSERT_EQ(connect(s, (struct sockaddr *)&addr, sizeof(addr)), 0);
+            for (int j = 0; j < 100; j++) {
+                std::string msg = std::to_string(i) + ":" + std::to_string(j);
+                ASSERT_EQ(write(s, msg.data(), msg.size()), ssize_t(msg.size()));
+
+                std::string reply;
+                char buffer[256];
+                while (reply.size() < msg.size()) {
+                    ssize_t n = read(s, buffer, sizeof(buffer));
+                    ASSERT_GT(n, 0);
+                    reply.append(buffer, n);
+                }
+                EXPECT_EQ(reply, msg);
+            }
+            close(s);
+        });
+    }
+
+    Epoll io;
+    Engine engine([&io](Engine &pe) { io.Poll(pe); }, Engine::StackMode::FixedStack);
+    engine.start(_acceptor, engine, io, std::move(server), int(n_clients));
+
+    for (auto &t : clients) {
+        t.join();
+    }
+    close(server);
+}
+
+void _sleeper(Engine &engine, Epoll &io, int ms, std::vector<int> &order) {
+    io.sleep_for(engine, std::chrono::milliseconds(ms));
+    order.push_back(ms);
+}
+
+void _sleepers(Engine &engine, Epoll &io, std::vector<int> &order) {
+    for (int ms : {30, 10, 50, 20, 40}) {
+        engine.run(_sleeper, engine, io, std::move(ms), order);
+    }
+}
+
+void _sleep(Engine::StackMode mode) {
+    Epoll io;
+    Engine engine([&io](Engine &pe) { io.Poll(pe); }, mode);
+
+    std::vector<int> order;
+    auto start = Epoll::clock::now();
+    engine.start(_sleepers, engine, io, order);
+
+    // Sleeps overlap, so it takes the longest one, and wake up in deadlines order
+    auto elapsed = Epoll::clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(150));
+    EXPECT_EQ(order, std::vector<int>({10, 20, 30, 40, 50}));
+    EXPECT_EQ(io.Waiting(), 0);
+}
+
+TEST(EpollTest, Sleep) { _sleep(Engine::StackMode::FixedStack); }
+
+// Stacks of blocked coroutines are saved and overwritten by others, timers must not live there
+TEST(EpollTest, StackCopySleep) { _sleep(Engine::StackMode::StackCopy); }
+
+void _timed_reader(Engine &engine, Epoll &io, int fd, ssize_t &result, int &error) {
+    char buffer[16];
+    result = io.co_read(engine, fd, buffer, sizeof(buffer), Epoll::clock::now() + std::chrono::milliseconds(20));
+    error = errno;
+}
+
+void _late_writer(Engine &engine, Epoll &io, int fd, int ms) {
+    io.sleep_for(engine, std::chrono::milliseconds(ms));
+    EXPECT_EQ(io.co_write(engine, fd, "ping", 4), 4);
+}
+
+void _timed_pipe(Engine &engine, Epoll &io, int read_fd, int write_fd, int delay, ssize_t &result, int &error) {
+    engine.run(_timed_reader, engine, io, std::move(read_fd), result, error);
+    engine.run(_late_writer, engine, io, std::move(write_fd), std::move(delay));
+}
+
+void _read_timeout(Engine::StackMode mode) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    Epoll io;
+    Engine engine([&io](Engine &pe) { io.Poll(pe); }, mode);
+
+    // Data arrives before deadline
+    ssize_t result = 0;
+    int error = 0;
+    engine.start(_timed_pipe, engine, io, int(fds[0]), int(fds[1]), 5, result, error);
+    EXPECT_EQ(result, 4);
+
+    // Data arrives too late
+    auto start = Epoll::clock::now();
+    engine.start(_timed_pipe, engine, io, int(fds[0]), int(fds[1]), 60, result, error);
+    EXPECT_EQ(result, -1);
+    EXPECT_EQ(error, ETIMEDOUT);
+    EXPECT_GE(Epoll::clock::now() - start, std::chrono::milliseconds(60));
+    EXPECT_EQ(io.Waiting(), 0);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(EpollTest, ReadTimeout) { _read_timeout(Engine::StackMode::FixedStack); }
+
+TEST(EpollTest, StackCopyReadTimeout) { _read_timeout(Engine::StackMode::StackCopy); }
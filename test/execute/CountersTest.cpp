@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/execute/Counters.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/Stats.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina::Execute;
+
+namespace {
+
+std::string stat(const std::string &name) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    Counters::Collect(stats);
+    for (auto &s : stats) {
+        if (s.first == name) {
+            return s.second;
+        }
+    }
+    return "";
+}
+
+// Counters are process wide, so tests look at how much they have changed
+uint64_t counter(const std::string &name) { return std::stoull(stat(name)); }
+
+} // namespace
+
+TEST(CountersTest, GetHitsAndMisses) {
+    Afina::Backend::SimpleLRU storage;
+    storage.Put("a", "12345");
+    storage.Put("b", "678");
+
+    uint64_t gets = counter("cmd_get"), hits = counter("get_hits");
+    uint64_t misses = counter("get_misses"), bytes = counter("get_bytes");
+
+    std::string out;
+    Get({"a", "b", "c"}).Execute(storage, "", out);
+    Get({"d"}).Execute(storage, "", out);
+
+    EXPECT_EQ(counter("cmd_get") - gets, 4);
+    EXPECT_EQ(counter("get_hits") - hits, 2);
+    EXPECT_EQ(counter("get_misses") - misses, 2);
+    EXPECT_EQ(counter("get_bytes") - bytes, 8);
+
+    Stats().Execute(storage, "", out);
+    EXPECT_NE(out.find("STAT get_hits " + std::to_string(hits + 2) + "\r\n"), std::string::npos);
+}
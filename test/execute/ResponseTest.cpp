@@ -0,0 +1,111 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+#include <afina/execute/Get.h>
+#include <afina/execute/Response.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina::Execute;
+
+namespace {
+
+std::string contents(const Response &response) {
+    std::string out;
+    response.CopyTo(out);
+    return out;
+}
+
+} // namespace
+
+TEST(ResponseTest, CopiedBytesMerge) {
+    Response response;
+    response.Append("VALUE ", 6);
+    response.Append(std::string("key\r\n"));
+    EXPECT_EQ(response.Size(), 11);
+
+    struct iovec iov[4];
+    ASSERT_EQ(response.Fill(iov, 4), 1);
+    EXPECT_EQ(std::string(static_cast<char *>(iov[0].iov_base), iov[0].iov_len), "VALUE key\r\n");
+}
+
+TEST(ResponseTest, ReferenceKeptUntilConsumed) {
+    Response response;
+    auto value = std::make_shared<const std::string>("value");
+    std::weak_ptr<const std::string> watch = value;
+
+    response.Append("a", 1);
+    response.Reference(value);
+    response.Append("b", 1);
+    EXPECT_EQ(contents(response), "avalueb");
+
+    // Bytes are referenced, not copied
+    struct iovec iov[4];
+    ASSERT_EQ(response.Fill(iov, 4), 3);
+    EXPECT_EQ(iov[1].iov_base, value->data());
+    value.reset();
+    EXPECT_FALSE(watch.expired());
+
+    // Partially sent value is still needed
+    response.Consume(3);
+    EXPECT_FALSE(watch.expired());
+    EXPECT_EQ(contents(response), "lueb");
+    ASSERT_EQ(response.Fill(iov, 4), 2);
+    EXPECT_EQ(std::string(static_cast<char *>(iov[0].iov_base), iov[0].iov_len), "lue");
+
+    response.Consume(3);
+    EXPECT_TRUE(watch.expired());
+    response.Consume(1);
+    EXPECT_TRUE(response.Empty());
+}
+
+TEST(ResponseTest, SlowReader) {
+    // Responses are added while older ones are sent piece by piece
+    Response response;
+    std::string sent, expected;
+    for (int i = 0; i < 1000; i++) {
+        std::string header = "VALUE " + std::to_string(i) + "\r\n";
+        auto value = std::make_shared<const std::string>(std::string(i % 7, 'x'));
+        response.Append(header);
+        response.Reference(value);
+        expected += header + *value;
+
+        struct iovec iov[2];
+        std::size_t count = response.Fill(iov, 2);
+        ASSERT_GT(count, 0);
+        std::size_t n = std::min<std::size_t>(iov[0].iov_len, 5);
+        sent.append(static_cast<char *>(iov[0].iov_base), n);
+        response.Consume(n);
+    }
+
+    response.CopyTo(sent);
+    EXPECT_EQ(sent, expected);
+}
+
+TEST(ResponseTest, GetMatchesStringVersion) {
+    Afina::Backend::SimpleLRU storage(1 << 20);
+    ASSERT_TRUE(storage.Put("a", "12345"));
+    ASSERT_TRUE(storage.Put("b", std::string(100000, 'v')));
+
+    std::string out;
+    Get({"a", "c", "b"}).Execute(storage, "", out);
+
+    Response response;
+    Get({"a", "c", "b"}).Execute(storage, "", response);
+    EXPECT_EQ(contents(response), out + "\r\n");
+
+    // Large value is a separate segment referencing the blob kept by storage
+    Afina::Storage::Value blob;
+    ASSERT_TRUE(storage.Get("b", blob));
+    struct iovec iov[8];
+    std::size_t count = response.Fill(iov, 8);
+    std::size_t referenced = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        if (iov[i].iov_base == blob->data()) {
+            EXPECT_EQ(iov[i].iov_len, blob->size());
+            referenced++;
+        }
+    }
+    EXPECT_EQ(referenced, 1);
+}
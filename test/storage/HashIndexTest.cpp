@@ -0,0 +1,66 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "storage/HashIndex.h"
+
+using namespace Afina::Backend;
+
+namespace {
+
+struct item {
+    std::string key;
+    int value;
+};
+
+struct item_key {
+    const std::string &operator()(const item &i) const { return i.key; }
+};
+
+} // namespace
+
+TEST(HashIndexTest, InsertFind) {
+    HashIndex<item, item_key> index;
+    item a{"a", 1}, b{"b", 2};
+
+    EXPECT_EQ(nullptr, index.find("a"));
+    index.insert(&a);
+    index.insert(&b);
+
+    EXPECT_EQ(2, index.size());
+    EXPECT_EQ(&a, index.find("a"));
+    EXPECT_EQ(&b, index.find("b"));
+    EXPECT_EQ(nullptr, index.find("c"));
+}
+
+TEST(HashIndexTest, EraseKeepsOthersReachable) {
+    const int count = 10000;
+    HashIndex<item, item_key> index;
+
+    std::vector<std::unique_ptr<item>> items;
+    for (int i = 0; i < count; ++i) {
+        items.emplace_back(new item{"Key " + std::to_string(i), i});
+        index.insert(items.back().get());
+    }
+
+    // Remove every third element, backward shift must not break probe chains of the rest
+    for (int i = 0; i < count; i += 3) {
+        EXPECT_EQ(items[i].get(), index.erase(items[i]->key));
+        EXPECT_EQ(nullptr, index.erase(items[i]->key));
+    }
+
+    for (int i = 0; i < count; ++i) {
+        item *found = index.find(items[i]->key);
+        if (i % 3 == 0) {
+            EXPECT_EQ(nullptr, found);
+        } else {
+            ASSERT_NE(nullptr, found);
+            EXPECT_EQ(i, found->value);
+        }
+    }
+
+    index.clear();
+    EXPECT_EQ(0, index.size());
+    EXPECT_EQ(nullptr, index.find(items[1]->key));
+}
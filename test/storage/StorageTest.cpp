@@ -2,14 +2,18 @@
 #include <iomanip>
 #include <iostream>
 #include <set>
+#include <thread>
 #include <vector>
 
+#include <afina/allocator/Simple.h>
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include "storage/FlatCombiningLRU.h"
+#include "storage/ShardedLRU.h"
 #include "storage/SimpleLRU.h"
 
 using namespace Afina::Backend;
@@ -139,6 +143,25 @@ TEST(StorageTest, DeleteHeadAndTailNode)
     EXPECT_TRUE(storage.Delete("KEY1"));
 }
 
+TEST(StorageTest, UpdateResize) {
+    SimpleLRU storage(16);
+
+    EXPECT_TRUE(storage.Put("KEY1", "v"));
+    EXPECT_TRUE(storage.Put("KEY2", "v"));
+
+    // KEY2 grows and pushes KEY1 out
+    EXPECT_TRUE(storage.Set("KEY2", "longvalue"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("longvalue", value);
+
+    EXPECT_TRUE(storage.Put("KEY2", "s"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("s", value);
+}
+
 std::string pad_space(const std::string &s, size_t length) {
     std::string result = s;
     result.resize(length, ' ');
@@ -195,3 +218,275 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(StorageTest, ShardedPutGet) {
+    ShardedLRU storage(8, 1024);
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i)));
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        std::string res;
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), res));
+        EXPECT_EQ("Val " + std::to_string(i), res);
+    }
+
+    EXPECT_FALSE(storage.PutIfAbsent("Key 1", "other"));
+    EXPECT_TRUE(storage.Set("Key 1", "other"));
+    EXPECT_TRUE(storage.Delete("Key 1"));
+
+    std::string res;
+    EXPECT_FALSE(storage.Get("Key 1", res));
+}
+
+TEST(StorageTest, ShardedConcurrent) {
+    const size_t length = 20;
+    const int n_threads = 4, per_thread = 10000;
+    ShardedLRU storage(16, 2 * n_threads * per_thread * length);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&storage, t, per_thread, length]() {
+            for (int i = t * per_thread; i < (t + 1) * per_thread; ++i) {
+                auto key = pad_space("Key " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                EXPECT_TRUE(storage.Put(key, val));
+
+                std::string res;
+                EXPECT_TRUE(storage.Get(key, res));
+                EXPECT_EQ(val, res);
+            }
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (int i = 0; i < n_threads * per_thread; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+    }
+}
+
+TEST(StorageTest, FlatCombiningConcurrent) {
+    const size_t length = 20;
+    const int n_threads = 4, per_thread = 10000;
+    FlatCombiningLRU storage(2 * n_threads * per_thread * length);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&storage, t, per_thread, length]() {
+            for (int i = t * per_thread; i < (t + 1) * per_thread; ++i) {
+                auto key = pad_space("Key " + std::to_string(i), length);
+                auto val = pad_space("Val " + std::to_string(i), length);
+                EXPECT_TRUE(storage.Put(key, val));
+                EXPECT_FALSE(storage.PutIfAbsent(key, val));
+
+                std::string res;
+                EXPECT_TRUE(storage.Get(key, res));
+                EXPECT_EQ(val, res);
+            }
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (int i = 0; i < n_threads * per_thread; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(storage.Delete(key));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.GetStats(stats);
+    EXPECT_FALSE(stats.empty());
+}
+
+TEST(StorageTest, ArenaEviction) {
+    std::vector<char> arena(64 * 1024);
+    Afina::Allocator::Simple allocator(arena.data(), arena.size());
+
+    // Byte limit is way above arena size, so only allocator may trigger eviction
+    SimpleLRU storage(1 << 30, allocator);
+
+    const size_t length = 100;
+    for (long i = 0; i < 2000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    // The most recent entries survive
+    for (long i = 1990; i < 2000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+
+        std::string res;
+        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(val == res);
+    }
+
+    std::string res;
+    EXPECT_FALSE(storage.Get(pad_space("Key 0", length), res));
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.GetStats(stats);
+
+    uint64_t evictions = 0, evicted = 0;
+    for (auto &s : stats) {
+        if (s.first == "evictions") {
+            evictions = std::stoull(s.second);
+        } else if (s.first.find(":evicted") != std::string::npos) {
+            evicted += std::stoull(s.second);
+        }
+    }
+    EXPECT_GT(evictions, 0);
+    EXPECT_EQ(evictions, evicted);
+
+    // Entry larger than whole arena could never be stored
+    EXPECT_FALSE(storage.Put("huge", std::string(arena.size(), 'x')));
+}
+
+TEST(StorageTest, ArenaClassEviction) {
+    std::vector<char> arena(64 * 1024);
+    Afina::Allocator::Simple allocator(arena.data(), arena.size());
+    SimpleLRU storage(1 << 30, allocator);
+
+    // Old small entries, then larger ones until arena is full
+    for (long i = 0; i < 20; ++i) {
+        EXPECT_TRUE(storage.Put("Small " + std::to_string(i), "v"));
+    }
+    auto evictions = [&storage]() {
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage.GetStats(stats);
+        for (auto &s : stats) {
+            if (s.first == "evictions") {
+                return std::stoull(s.second);
+            }
+        }
+        return 0ull;
+    };
+    long n = 0;
+    for (; n < 1000 && evictions() < 10; ++n) {
+        EXPECT_TRUE(storage.Put("Large " + std::to_string(n), pad_space("Val", 300)));
+    }
+    ASSERT_LT(n, 1000);
+
+    // Larger ones are evicted in their own class, small entries don't free room for them
+    for (long i = 0; i < 20; ++i) {
+        std::string res;
+        EXPECT_TRUE(storage.Get("Small " + std::to_string(i), res));
+    }
+}
+
+TEST(StorageTest, ArenaCompaction) {
+    std::vector<char> arena(64 * 1024);
+    Afina::Allocator::Simple allocator(arena.data(), arena.size());
+    SimpleLRU storage(1 << 30, allocator);
+
+    // Small entries spread over many slabs, then most of them go away leaving slabs sparse
+    for (long i = 0; i < 300; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), pad_space("Val " + std::to_string(i), 50)));
+    }
+    for (long i = 0; i < 300; ++i) {
+        if (i % 4 != 0) {
+            EXPECT_TRUE(storage.Delete("Key " + std::to_string(i)));
+        }
+    }
+
+    // Large entries need whole slabs, those could only be found by compacting small ones
+    for (long i = 0; i < 80; ++i) {
+        EXPECT_TRUE(storage.Put("Big " + std::to_string(i), pad_space("Val " + std::to_string(i), 350)));
+    }
+
+    std::string res;
+    for (long i = 0; i < 300; i += 4) {
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), res));
+        EXPECT_TRUE(res == pad_space("Val " + std::to_string(i), 50));
+    }
+    for (long i = 0; i < 80; ++i) {
+        EXPECT_TRUE(storage.Get("Big " + std::to_string(i), res));
+        EXPECT_TRUE(res == pad_space("Val " + std::to_string(i), 350));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.GetStats(stats);
+    for (auto &s : stats) {
+        if (s.first == "evictions") {
+            EXPECT_EQ(s.second, "0");
+        }
+    }
+}
+
+TEST(StorageTest, ArenaIdleCompaction) {
+    std::vector<char> arena(64 * 1024);
+    Afina::Allocator::Simple allocator(arena.data(), arena.size());
+    SimpleLRU storage(1 << 30, allocator);
+
+    auto slabs = [&allocator]() {
+        size_t result = 0;
+        for (auto &s : allocator.stats()) {
+            result += s.slabs;
+        }
+        return result;
+    };
+
+    for (long i = 0; i < 300; ++i) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), pad_space("Val " + std::to_string(i), 50)));
+    }
+    size_t full = slabs();
+
+    // Every slab keeps some entries, so it is only compaction that could release slabs. It runs
+    // between operations without any memory pressure
+    for (long i = 0; i < 300; ++i) {
+        if (i % 4 != 0) {
+            EXPECT_TRUE(storage.Delete("Key " + std::to_string(i)));
+        }
+    }
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_FALSE(storage.Delete("Missing " + std::to_string(i)));
+    }
+    EXPECT_LT(slabs(), full / 2);
+
+    std::string res;
+    for (long i = 0; i < 300; i += 4) {
+        EXPECT_TRUE(storage.Get("Key " + std::to_string(i), res));
+        EXPECT_TRUE(res == pad_space("Val " + std::to_string(i), 50));
+    }
+}
+
+TEST(StorageTest, SharedValue) {
+    SimpleLRU storage(10000);
+    std::string big(4000, 'a');
+    EXPECT_TRUE(storage.Put("Big", big));
+    EXPECT_TRUE(storage.Put("Small", "value"));
+
+    Afina::Storage::Value small, first, second;
+    EXPECT_TRUE(storage.Get("Small", small));
+    EXPECT_EQ(*small, "value");
+    EXPECT_TRUE(storage.Get("Big", first));
+    EXPECT_TRUE(storage.Get("Big", second));
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_FALSE(storage.Get("Missing", second));
+
+    // Readers keep the old value when key is updated in place or evicted
+    EXPECT_TRUE(storage.Set("Big", std::string(4000, 'b')));
+    EXPECT_EQ(*first, big);
+    EXPECT_TRUE(storage.Get("Big", second));
+    EXPECT_EQ(*second, std::string(4000, 'b'));
+
+    EXPECT_TRUE(storage.Put("Other", std::string(5000, 'c')));
+    EXPECT_TRUE(storage.Put("Another", std::string(5000, 'd')));
+    std::string res;
+    EXPECT_FALSE(storage.Get("Big", res));
+    EXPECT_EQ(*second, std::string(4000, 'b'));
+
+    EXPECT_TRUE(storage.Get("Another", res));
+    EXPECT_EQ(res, std::string(5000, 'd'));
+}